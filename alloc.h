@@ -0,0 +1,136 @@
+/*
+ * This library is a part of the C header-only libraries collection
+ * (https://github.com/LordOfTrident/chol)
+ *
+ * This library has no implementation section, all of its functions are static inline, so it can
+ * be included anywhere without defining an implementation macro.
+ *
+ * This library provides an allocator interface, which the other libraries take to route their
+ * allocations through a custom allocator (an arena, a pool, a tracking allocator...).
+ */
+
+/* Simple example of the library:
+#include <stdio.h>
+
+#include <chol/alloc.h>
+
+static size_t allocs = 0;
+
+static void *counting_alloc(void *ctx, size_t size) {
+	++ *(size_t*)ctx;
+	return malloc(size);
+}
+
+int main(void) {
+	allocator_t a = allocator_libc();
+	a.alloc = counting_alloc;
+	a.ctx   = &allocs;
+
+	void *ptr = allocator_alloc(&a, 16);
+	allocator_free(&a, ptr);
+
+	printf("%zu allocations\n", allocs);
+	return 0;
+}
+*/
+
+#ifndef CHOL_ALLOC_H_HEADER_GUARD
+#define CHOL_ALLOC_H_HEADER_GUARD
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h> /* size_t, malloc, realloc, free */
+
+#define CHOL_ALLOC_VERSION_MAJOR 1
+#define CHOL_ALLOC_VERSION_MINOR 0
+#define CHOL_ALLOC_VERSION_PATCH 0
+
+/*
+ * 1.0.0: Allocator interface with a libc default
+ */
+
+typedef struct {
+	void *(*alloc)(  void *ctx, size_t size);
+	void *(*realloc)(void *ctx, void *ptr, size_t size);
+	void  (*free)(   void *ctx, void *ptr);
+	void  *ctx;
+} allocator_t;
+
+/*
+ * allocator_t
+ *     Allocator structure. The functions follow the semantics of malloc, realloc and free, but
+ *     each also receives the user context 'ctx'.
+ *
+ *     void *(*alloc)(void *ctx, size_t size)
+ *         Allocates 'size' bytes. Returns NULL on fail.
+ *     void *(*realloc)(void *ctx, void *ptr, size_t size)
+ *         Resizes the allocation 'ptr' (which may be NULL) to 'size' bytes. Returns NULL on fail,
+ *         in which case 'ptr' stays valid.
+ *     void (*free)(void *ctx, void *ptr)
+ *         Frees the allocation 'ptr' (which may be NULL).
+ *     void *ctx
+ *         User context passed to the functions
+ */
+
+static inline void *allocator_libc_alloc(void *ctx, size_t size) {
+	(void)ctx;
+	return malloc(size);
+}
+
+static inline void *allocator_libc_realloc(void *ctx, void *ptr, size_t size) {
+	(void)ctx;
+	return realloc(ptr, size);
+}
+
+static inline void allocator_libc_free(void *ctx, void *ptr) {
+	(void)ctx;
+	free(ptr);
+}
+
+static inline allocator_t allocator_libc(void) {
+	allocator_t a;
+	a.alloc   = allocator_libc_alloc;
+	a.realloc = allocator_libc_realloc;
+	a.free    = allocator_libc_free;
+	a.ctx     = NULL;
+	return a;
+}
+
+static inline void *allocator_alloc(const allocator_t *a, size_t size) {
+	return a == NULL? malloc(size) : a->alloc(a->ctx, size);
+}
+
+static inline void *allocator_realloc(const allocator_t *a, void *ptr, size_t size) {
+	return a == NULL? realloc(ptr, size) : a->realloc(a->ctx, ptr, size);
+}
+
+static inline void allocator_free(const allocator_t *a, void *ptr) {
+	if (a == NULL)
+		free(ptr);
+	else
+		a->free(a->ctx, ptr);
+}
+
+/*
+ * A NULL allocator pointer stands for the libc allocator everywhere, so the default costs only a
+ * pointer check and no indirect call.
+ *
+ * allocator_t allocator_libc(void)
+ *     Returns an allocator that uses malloc, realloc and free. Useful as a base for allocators
+ *     that override only some of the functions.
+ *
+ * void *allocator_alloc(const allocator_t *a, size_t size)
+ *     Allocates 'size' bytes with 'a'. Returns NULL on fail.
+ *
+ * void *allocator_realloc(const allocator_t *a, void *ptr, size_t size)
+ *     Reallocates 'ptr' to 'size' bytes with 'a'. Returns NULL on fail and keeps 'ptr' valid.
+ *
+ * void allocator_free(const allocator_t *a, void *ptr)
+ *     Frees 'ptr' with 'a'.
+ */
+
+#ifdef __cplusplus
+}
+#endif
+#endif
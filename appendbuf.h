@@ -0,0 +1,320 @@
+/*
+ * This library is a part of the C header-only libraries collection
+ * (https://github.com/LordOfTrident/chol)
+ *
+ * This is an STB-style library, so to include the library implementation, you need to define
+ * the implementation macro:
+ *     #define CHOL_APPENDBUF_IMPLEMENTATION
+ *
+ * The buffer is frozen into a darray_t though, so the implementation of darray.h has to be
+ * included in one of the files:
+ *     #define CHOL_DARRAY_IMPLEMENTATION
+ *
+ * This library provides a lock-free multi-producer append buffer. Any number of threads can append
+ * to it at the same time without a mutex: each append reserves its slot with a single atomic
+ * fetch-add. Once all the producers are done, the buffer is frozen into a darray_t for
+ * single-threaded consumers.
+ */
+
+/* Simple example of the library:
+#include <stdio.h>
+
+#define CHOL_DARRAY_IMPLEMENTATION
+#define CHOL_APPENDBUF_IMPLEMENTATION
+#include <chol/appendbuf.h>
+
+int main(void) {
+	appendbuf_t buf;
+	APPENDBUF_INIT(&buf, int);
+
+	// from any thread
+	int num = 5;
+	appendbuf_push(&buf, &num);
+
+	// after all the threads are joined
+	darray_t nums;
+	DARRAY_INIT(&nums, int);
+	appendbuf_freeze(&buf, &nums);
+
+	appendbuf_free(&buf);
+	DARRAY_FREE(&nums);
+	return 0;
+}
+*/
+
+#ifndef CHOL_APPENDBUF_H_HEADER_GUARD
+#define CHOL_APPENDBUF_H_HEADER_GUARD
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>  /* size_t */
+#include <string.h>  /* memcpy */
+#include <stdint.h>  /* SIZE_MAX */
+#include <stdbool.h> /* bool, true, false */
+
+#include "alloc.h"
+#include "darray.h"
+
+#define CHOL_APPENDBUF_VERSION_MAJOR 1
+#define CHOL_APPENDBUF_VERSION_MINOR 0
+#define CHOL_APPENDBUF_VERSION_PATCH 1
+
+/*
+ * 1.0.0: Lock-free multi-producer append buffer with freezing into darray_t
+ * 1.0.1: Do not define the darray.h implementation, which broke programs that also define it
+ */
+
+#ifndef APPENDBUF_FIRST_SHIFT
+#	define APPENDBUF_FIRST_SHIFT 8
+#endif
+
+#define APPENDBUF_FIRST_SIZE ((size_t)1 << APPENDBUF_FIRST_SHIFT)
+#define APPENDBUF_MAX_BLOCKS (sizeof(size_t) * 8 - APPENDBUF_FIRST_SHIFT)
+
+typedef struct {
+	void  *blocks[sizeof(size_t) * 8];
+	size_t count, elem_size;
+	bool   failed;
+
+	const allocator_t *allocator;
+} appendbuf_t;
+
+/*
+ * APPENDBUF_FIRST_SHIFT
+ *     The size of the first segment is 2 to the power of APPENDBUF_FIRST_SHIFT elements, each next
+ *     segment is twice the size of the previous one. If not defined before including, the default
+ *     is 8 (256 elements).
+ *
+ *     appendbuf_t
+ *         Append buffer structure. The elements are stored in segments of growing size (like
+ *         segarray_t), so a reserved slot never moves, and a producer never waits for another one
+ *         to copy the buffer. The fields are accessed atomically while producers are running.
+ *
+ *         void *blocks[]
+ *             The segments, NULL if not allocated yet
+ *         size_t count
+ *             Count of reserved slots
+ *         size_t elem_size
+ *             Size of a single element in bytes
+ *         bool failed
+ *             Set if a segment allocation failed
+ *         const allocator_t *allocator
+ *             The allocator of the segments, NULL for libc (see alloc.h). It has to be thread
+ *             safe.
+ */
+
+#define APPENDBUF_INIT(B, TYPE) appendbuf_init(B, sizeof(TYPE))
+
+void appendbuf_init(     appendbuf_t *b, size_t elem_size);
+void appendbuf_init_with(appendbuf_t *b, size_t elem_size, const allocator_t *a);
+void appendbuf_free(     appendbuf_t *b);
+int  appendbuf_reserve(  appendbuf_t *b, size_t count);
+
+void *appendbuf_add( appendbuf_t *b);
+int   appendbuf_push(appendbuf_t *b, const void *data);
+
+int  appendbuf_freeze(appendbuf_t *b, darray_t *d);
+
+/*
+ * APPENDBUF_INIT(B, TYPE)
+ *     Initializes 'B' for the type 'TYPE'.
+ *
+ * Thread safe: appendbuf_add and appendbuf_push. The other functions must be called while no
+ * producer is running (before starting or after joining them).
+ *
+ * void appendbuf_init(appendbuf_t *b, size_t elem_size)
+ *     Initializes 'b' as empty. Does not allocate.
+ *
+ * void appendbuf_init_with(appendbuf_t *b, size_t elem_size, const allocator_t *a)
+ *     Same as appendbuf_init, but 'b' allocates with 'a'.
+ *
+ * void appendbuf_free(appendbuf_t *b)
+ *     Frees 'b'.
+ *
+ * int appendbuf_reserve(appendbuf_t *b, size_t count)
+ *     Pre-grows 'b' by allocating the segments for 'count' elements, so that the producers only
+ *     do the fetch-add. Returns 0 on success.
+ *
+ * void *appendbuf_add(appendbuf_t *b)
+ *     Reserves a slot in 'b' and returns a pointer to it, which the caller writes the element
+ *     into. If the segment of the slot is not allocated yet, it is allocated and published with
+ *     a compare-and-swap, so racing producers never block each other. Returns NULL on allocation
+ *     fail, which also makes appendbuf_freeze fail.
+ *
+ * int appendbuf_push(appendbuf_t *b, const void *data)
+ *     Appends the element 'data' to 'b'. Returns 0 on success.
+ *
+ * int appendbuf_freeze(appendbuf_t *b, darray_t *d)
+ *     Appends all the elements of 'b' to 'd' with a single reservation and one copy per segment,
+ *     then empties 'b' (keeping its segments for reuse). The element size of 'd' has to be the
+ *     same as of 'b'. Returns 0 on success, -1 if the sizes do not match, an append has failed
+ *     or 'd' failed to grow.
+ */
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+#ifdef CHOL_APPENDBUF_IMPLEMENTATION
+#if defined(_MSC_VER) && !defined(__clang__)
+#	include "sys.h"
+#	include <intrin.h> /* _BitScanReverse, _BitScanReverse64 */
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#	define APPENDBUF_FETCH_ADD(PTR, N) __atomic_fetch_add(PTR, N, __ATOMIC_RELAXED)
+#	define APPENDBUF_LOAD(PTR)         __atomic_load_n(PTR, __ATOMIC_ACQUIRE)
+#	define APPENDBUF_STORE(PTR, VAL)   __atomic_store_n(PTR, VAL, __ATOMIC_RELEASE)
+#	define APPENDBUF_CAS(PTR, EXP, NEW) \
+		__atomic_compare_exchange_n(PTR, &(EXP), NEW, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#elif defined(_MSC_VER)
+#	ifdef _WIN64
+#		define APPENDBUF_FETCH_ADD(PTR, N) \
+			(size_t)InterlockedExchangeAdd64((volatile LONG64*)(PTR), (LONG64)(N))
+#	else
+#		define APPENDBUF_FETCH_ADD(PTR, N) \
+			(size_t)InterlockedExchangeAdd((volatile LONG*)(PTR), (LONG)(N))
+#	endif
+#	define APPENDBUF_LOAD(PTR)       (*(volatile void**)(PTR))
+#	define APPENDBUF_STORE(PTR, VAL) (*(volatile bool*)(PTR) = (VAL))
+#	define APPENDBUF_CAS(PTR, EXP, NEW) \
+		(InterlockedCompareExchangePointer((PVOID volatile*)(PTR), NEW, EXP) == (EXP))
+#else
+#	error "appendbuf.h needs GCC/Clang atomic builtins or MSVC interlocked functions"
+#endif
+
+/* Returns the index of the highest set bit of 'x', which must not be 0 */
+static size_t appendbuf_log2(size_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+	return sizeof(unsigned long long) * 8 - 1 - (size_t)__builtin_clzll((unsigned long long)x);
+#elif defined(_WIN64)
+	unsigned long idx;
+	_BitScanReverse64(&idx, x);
+	return idx;
+#else
+	unsigned long idx;
+	_BitScanReverse(&idx, x);
+	return idx;
+#endif
+}
+
+/* Splits the index 'idx' into the segment and the offset in it */
+static size_t appendbuf_locate(size_t idx, size_t *offset) {
+	size_t i     = idx + APPENDBUF_FIRST_SIZE;
+	size_t block = appendbuf_log2(i) - APPENDBUF_FIRST_SHIFT;
+
+	*offset = i - (APPENDBUF_FIRST_SIZE << block);
+	return block;
+}
+
+static size_t appendbuf_block_size(size_t block) {
+	return APPENDBUF_FIRST_SIZE << block;
+}
+
+void appendbuf_init(appendbuf_t *b, size_t elem_size) {
+	appendbuf_init_with(b, elem_size, NULL);
+}
+
+void appendbuf_init_with(appendbuf_t *b, size_t elem_size, const allocator_t *a) {
+	memset(b->blocks, 0, sizeof(b->blocks));
+	b->count     = 0;
+	b->elem_size = elem_size;
+	b->failed    = false;
+	b->allocator = a;
+}
+
+void appendbuf_free(appendbuf_t *b) {
+	for (size_t i = 0; i < APPENDBUF_MAX_BLOCKS; ++ i)
+		allocator_free(b->allocator, b->blocks[i]);
+
+	appendbuf_init_with(b, b->elem_size, b->allocator);
+}
+
+/* Returns segment 'block', allocating it if it does not exist yet */
+static void *appendbuf_block(appendbuf_t *b, size_t block) {
+	void *ptr = APPENDBUF_LOAD(&b->blocks[block]);
+	if (ptr != NULL)
+		return ptr;
+
+	if (block >= APPENDBUF_MAX_BLOCKS || appendbuf_block_size(block) > SIZE_MAX / b->elem_size)
+		return NULL;
+
+	void *new_ = allocator_alloc(b->allocator, appendbuf_block_size(block) * b->elem_size);
+	if (new_ == NULL)
+		return NULL;
+
+	/* Another producer might have installed the segment in the meantime, use theirs then */
+	void *expected = NULL;
+	if (APPENDBUF_CAS(&b->blocks[block], expected, new_))
+		return new_;
+
+	allocator_free(b->allocator, new_);
+	return APPENDBUF_LOAD(&b->blocks[block]);
+}
+
+int appendbuf_reserve(appendbuf_t *b, size_t count) {
+	if (count == 0)
+		return 0;
+
+	size_t offset, last = appendbuf_locate(count - 1, &offset);
+	for (size_t i = 0; i <= last; ++ i) {
+		if (appendbuf_block(b, i) == NULL)
+			return -1;
+	}
+
+	return 0;
+}
+
+void *appendbuf_add(appendbuf_t *b) {
+	size_t offset, block = appendbuf_locate(APPENDBUF_FETCH_ADD(&b->count, 1), &offset);
+
+	char *ptr = (char*)appendbuf_block(b, block);
+	if (ptr == NULL) {
+		APPENDBUF_STORE(&b->failed, true);
+		return NULL;
+	}
+
+	return ptr + offset * b->elem_size;
+}
+
+int appendbuf_push(appendbuf_t *b, const void *data) {
+	void *slot = appendbuf_add(b);
+	if (slot == NULL)
+		return -1;
+
+	memcpy(slot, data, b->elem_size);
+	return 0;
+}
+
+int appendbuf_freeze(appendbuf_t *b, darray_t *d) {
+	if (b->failed || d->elem_size != b->elem_size || b->count > SIZE_MAX - d->count)
+		return -1;
+
+	if (darray_reserve(d, d->count + b->count) != 0)
+		return -1;
+
+	size_t left = b->count;
+	for (size_t i = 0; left > 0; ++ i) {
+		size_t n = appendbuf_block_size(i);
+		if (n > left)
+			n = left;
+
+		/* Cannot fail, the space is reserved */
+		darray_extend(d, b->blocks[i], n);
+		left -= n;
+	}
+
+	b->count = 0;
+	return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
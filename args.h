@@ -41,13 +41,15 @@ extern "C" {
 #endif
 
 #include <stdio.h>   /* fprintf, stderr, FILE */
-#include <stdlib.h>  /* size_t, malloc, free, strtol, strtoull, strtod */
+#include <stdlib.h>  /* size_t, strtol, strtoull, strtod */
 #include <stdbool.h> /* bool, true, false */
 #include <string.h>  /* strcmp, strlen, strdup, strcpy, strncpy */
 #include <assert.h>  /* assert */
 
+#include "alloc.h"
+
 #define CHOL_ARGS_VERSION_MAJOR 1
-#define CHOL_ARGS_VERSION_MINOR 2
+#define CHOL_ARGS_VERSION_MINOR 3
 #define CHOL_ARGS_VERSION_PATCH 3
 
 /*
@@ -57,6 +59,7 @@ extern "C" {
  * 1.2.1: Add FOREACH_IN_ARGS macro
  * 1.2.2: Change FOREACH_IN_ARGS iterator variable name from i to _i
  * 1.2.3: Fix get_flag_by_short_name and get_flag_by_long_name
+ * 1.3.3: Add args_set_allocator, return ARG_OUT_OF_MEM when a string flag value fails to allocate
  */
 
 #ifndef CONSTRUCT
@@ -159,6 +162,8 @@ void flag_bool( const char *short_name, const char *long_name, const char *desc,
 void args_print_flags(FILE *file);
 void args_print_usage(FILE *file, const char *app_name, const char *usage);
 
+void args_set_allocator(const allocator_t *a);
+
 /*
  * void flag_cstr(const char *short_name, const char *long_name, const char *desc, char **var)
  *     Register a c string flag with short name 'short_name', long name 'long_name' and description
@@ -179,6 +184,12 @@ void args_print_usage(FILE *file, const char *app_name, const char *usage);
  *     'Usage: <app_name> <usage>
  *      Options:
  *      <args_print_flags()>'
+ *
+ * void args_set_allocator(const allocator_t *a)
+ *     Makes args_parse_flags allocate the stripped arguments, string flag values and its
+ *     temporary buffers with 'a' (see alloc.h). NULL restores the default libc allocator. The
+ *     'base' of stripped arguments and string flag values then have to be freed with
+ *     allocator_free(a, ...).
  */
 
 #ifdef __cplusplus
@@ -260,6 +271,12 @@ typedef struct {
 flag_t flags[FLAGS_CAPACITY];
 size_t flags_count = 0;
 
+static const allocator_t *args_allocator = NULL;
+
+void args_set_allocator(const allocator_t *a) {
+	args_allocator = a;
+}
+
 static flag_t *get_flag_by_short_name(const char *short_name) {
 	if (short_name == NULL)
 		return NULL;
@@ -366,7 +383,10 @@ void flag_bool(const char *short_name, const char *long_name, const char *desc,
 static int flag_set(flag_t *f, const char *val) {
 	switch (f->type) {
 	case FLAG_CSTR: {
-		*f->as.cstr = (char*)malloc(strlen(val) + 1);
+		*f->as.cstr = (char*)allocator_alloc(args_allocator, strlen(val) + 1);
+		if (*f->as.cstr == NULL)
+			return ARG_OUT_OF_MEM;
+
 		strcpy(*f->as.cstr, val);
 	} break;
 
@@ -421,7 +441,7 @@ int args_parse_flags(args_t *a, int *where, args_t *stripped) {
 	   (allocate the same size as the original arguments so we dont have to do any reallocs) */
 	if (stripped != NULL) {
 		stripped->c    = 0;
-		stripped->base = (char**)malloc(sizeof(*stripped) * a->c);
+		stripped->base = (char**)allocator_alloc(args_allocator, sizeof(*stripped) * a->c);
 		if (stripped->base == NULL)
 			return ARG_OUT_OF_MEM;
 
@@ -465,7 +485,7 @@ int args_parse_flags(args_t *a, int *where, args_t *stripped) {
 		}
 
 		/* Allocate memory for flag name and copy it there */
-		char *name = (char*)malloc(count + 1);
+		char *name = (char*)allocator_alloc(args_allocator, count + 1);
 		if (name == NULL)
 			return ARG_OUT_OF_MEM;
 
@@ -491,7 +511,7 @@ int args_parse_flags(args_t *a, int *where, args_t *stripped) {
 			}
 
 			/* Allocate memory for value and copy it there */
-			val = (char*)malloc(count + 1);
+			val = (char*)allocator_alloc(args_allocator, count + 1);
 			if (val == NULL)
 				return ARG_OUT_OF_MEM;
 
@@ -522,10 +542,10 @@ int args_parse_flags(args_t *a, int *where, args_t *stripped) {
 			if (err != ARG_OK)
 				return err;
 
-			free(val);
+			allocator_free(args_allocator, val);
 		}
 
-		free(name);
+		allocator_free(args_allocator, name);
 	}
 
 	return ARG_OK;
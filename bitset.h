@@ -0,0 +1,383 @@
+/*
+ * This library is a part of the C header-only libraries collection
+ * (https://github.com/LordOfTrident/chol)
+ *
+ * This is an STB-style library, so to include the library implementation, you need to define
+ * the implementation macro:
+ *     #define CHOL_BITSET_IMPLEMENTATION
+ *
+ * This library provides a dynamic bitset. It stores one bit per flag in 64-bit words (8 times less
+ * memory than an array of bool), counts and searches the bits a word at a time, and combines two
+ * sets with SSE2/AVX2 where available.
+ */
+
+/* Simple example of the library:
+#include <stdio.h>
+
+#define CHOL_BITSET_IMPLEMENTATION
+#include <chol/bitset.h>
+
+int main(void) {
+	bitset_t seen;
+	bitset_init(&seen);
+	bitset_resize(&seen, 1000000);
+
+	bitset_set(&seen, 5);
+	bitset_set(&seen, 500000);
+
+	printf("%zu set, first: %zu\n", bitset_count(&seen), bitset_find_next(&seen, 0));
+	bitset_free(&seen);
+	return 0;
+}
+*/
+
+#ifndef CHOL_BITSET_H_HEADER_GUARD
+#define CHOL_BITSET_H_HEADER_GUARD
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>  /* size_t */
+#include <string.h>  /* memset */
+#include <stdint.h>  /* uint64_t, SIZE_MAX */
+#include <stdbool.h> /* bool, true, false */
+#include <assert.h>  /* assert */
+
+#include "alloc.h"
+
+#define CHOL_BITSET_VERSION_MAJOR 1
+#define CHOL_BITSET_VERSION_MINOR 0
+#define CHOL_BITSET_VERSION_PATCH 0
+
+/*
+ * 1.0.0: Dynamic bitset with popcount, rank, find next and bulk set operations
+ */
+
+#define BITSET_WORD_BITS   64
+#define BITSET_NPOS        ((size_t)-1)
+#define BITSET_WORDS(BITS) ((BITS) / BITSET_WORD_BITS + ((BITS) % BITSET_WORD_BITS != 0))
+
+typedef struct {
+	uint64_t *words;
+	size_t    bits, size;
+
+	const allocator_t *allocator;
+} bitset_t;
+
+/*
+ * BITSET_WORD_BITS
+ *     Count of bits in a word.
+ *
+ * BITSET_NPOS
+ *     Returned by bitset_find_next when there is no set bit.
+ *
+ * BITSET_WORDS(BITS)
+ *     Count of words needed to hold 'BITS' bits.
+ *
+ *     bitset_t
+ *         Bitset structure. The bits past 'bits' in the last word are always 0, so the word
+ *         operations do not need to mask them.
+ *
+ *         uint64_t *words
+ *             The words, bit 'i' is bit 'i % 64' of word 'i / 64'
+ *         size_t bits
+ *             Count of bits
+ *         size_t size
+ *             Count of allocated words
+ *         const allocator_t *allocator
+ *             The allocator of the words, NULL for libc (see alloc.h)
+ */
+
+#define FOREACH_SET_IN_BITSET(B, VAR, BODY) \
+	do { \
+		for (size_t _w = 0; _w < BITSET_WORDS((B)->bits); ++ _w) { \
+			for (uint64_t _word = (B)->words[_w]; _word != 0; _word &= _word - 1) { \
+				size_t VAR = _w * BITSET_WORD_BITS + bitset_ctz(_word); \
+				BODY \
+			} \
+		} \
+	} while (0)
+
+/*
+ * FOREACH_SET_IN_BITSET(B, VAR, BODY)
+ *     Loops through the indexes of the set bits in 'B' in ascending order, skipping zero words
+ *     whole. 'VAR' is the name of the index variable, which is of type size_t, and 'BODY' is the
+ *     code to run on each iteration.
+ */
+
+/* Returns the index of the lowest set bit of 'x', which must not be 0 */
+static inline size_t bitset_ctz(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+	return (size_t)__builtin_ctzll(x);
+#else
+	size_t idx = 0;
+	while ((x & 1) == 0) {
+		x >>= 1;
+		++ idx;
+	}
+
+	return idx;
+#endif
+}
+
+static inline void bitset_set(bitset_t *b, size_t idx) {
+	assert(idx < b->bits);
+	b->words[idx / BITSET_WORD_BITS] |= (uint64_t)1 << (idx % BITSET_WORD_BITS);
+}
+
+static inline void bitset_clear(bitset_t *b, size_t idx) {
+	assert(idx < b->bits);
+	b->words[idx / BITSET_WORD_BITS] &= ~((uint64_t)1 << (idx % BITSET_WORD_BITS));
+}
+
+static inline bool bitset_test(const bitset_t *b, size_t idx) {
+	assert(idx < b->bits);
+	return (b->words[idx / BITSET_WORD_BITS] >> (idx % BITSET_WORD_BITS)) & 1;
+}
+
+void bitset_init(     bitset_t *b);
+void bitset_init_with(bitset_t *b, const allocator_t *a);
+void bitset_free(     bitset_t *b);
+int  bitset_resize(   bitset_t *b, size_t bits);
+
+void bitset_set_all(  bitset_t *b);
+void bitset_clear_all(bitset_t *b);
+
+size_t bitset_count(    const bitset_t *b);
+size_t bitset_rank(     const bitset_t *b, size_t idx);
+size_t bitset_find_next(const bitset_t *b, size_t from);
+
+int bitset_and(   bitset_t *dst, const bitset_t *src);
+int bitset_or(    bitset_t *dst, const bitset_t *src);
+int bitset_xor(   bitset_t *dst, const bitset_t *src);
+int bitset_andnot(bitset_t *dst, const bitset_t *src);
+
+/*
+ * void bitset_set(bitset_t *b, size_t idx)
+ * void bitset_clear(bitset_t *b, size_t idx)
+ *     Sets/clears the bit 'idx' of 'b'. Asserts that 'idx' is in bounds.
+ *
+ * bool bitset_test(const bitset_t *b, size_t idx)
+ *     Returns the bit 'idx' of 'b'. Asserts that 'idx' is in bounds.
+ *
+ * void bitset_init(bitset_t *b)
+ *     Initializes 'b' as empty. Does not allocate.
+ *
+ * void bitset_init_with(bitset_t *b, const allocator_t *a)
+ *     Same as bitset_init, but 'b' allocates with 'a'.
+ *
+ * void bitset_free(bitset_t *b)
+ *     Frees 'b'.
+ *
+ * int bitset_resize(bitset_t *b, size_t bits)
+ *     Resizes 'b' to 'bits' bits. The new bits are cleared. Returns 0 on success.
+ *
+ * void bitset_set_all(bitset_t *b)
+ * void bitset_clear_all(bitset_t *b)
+ *     Sets/clears all the bits of 'b'.
+ *
+ * size_t bitset_count(const bitset_t *b)
+ *     Returns the count of set bits in 'b' (population count).
+ *
+ * size_t bitset_rank(const bitset_t *b, size_t idx)
+ *     Returns the count of set bits in 'b' below the index 'idx', which can be at most 'bits'.
+ *
+ * size_t bitset_find_next(const bitset_t *b, size_t from)
+ *     Returns the index of the first set bit in 'b' at or after 'from', or BITSET_NPOS if there is
+ *     none.
+ *
+ * int bitset_and(bitset_t *dst, const bitset_t *src)
+ * int bitset_or(bitset_t *dst, const bitset_t *src)
+ * int bitset_xor(bitset_t *dst, const bitset_t *src)
+ * int bitset_andnot(bitset_t *dst, const bitset_t *src)
+ *     Combines 'dst' with 'src' (dst & src, dst | src, dst ^ src, dst & ~src) into 'dst', 4 words
+ *     per step with AVX2, 2 with SSE2, otherwise a word at a time. Returns -1 if the sets do not
+ *     have the same count of bits, 0 otherwise.
+ */
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+#ifdef CHOL_BITSET_IMPLEMENTATION
+#if defined(__AVX2__)
+#	include <immintrin.h> /* _mm256_loadu_si256, _mm256_storeu_si256, ... */
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define BITSET_SSE2
+#	include <emmintrin.h> /* _mm_loadu_si128, _mm_storeu_si128, ... */
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static size_t bitset_popcount(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+	return (size_t)__builtin_popcountll(x);
+#else
+	x = x - ((x >> 1) & 0x5555555555555555ULL);
+	x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+	x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (size_t)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/* Clears the unused bits of the last word */
+static void bitset_mask_tail(bitset_t *b) {
+	if (b->bits % BITSET_WORD_BITS != 0)
+		b->words[b->bits / BITSET_WORD_BITS] &= ((uint64_t)1 << (b->bits % BITSET_WORD_BITS)) - 1;
+}
+
+void bitset_init(bitset_t *b) {
+	bitset_init_with(b, NULL);
+}
+
+void bitset_init_with(bitset_t *b, const allocator_t *a) {
+	b->words     = NULL;
+	b->bits      = 0;
+	b->size      = 0;
+	b->allocator = a;
+}
+
+void bitset_free(bitset_t *b) {
+	allocator_free(b->allocator, b->words);
+	bitset_init_with(b, b->allocator);
+}
+
+int bitset_resize(bitset_t *b, size_t bits) {
+	size_t words = BITSET_WORDS(bits);
+	if (words > b->size) {
+		size_t size = b->size <= SIZE_MAX / 2? b->size * 2 : words;
+		if (size < words)
+			size = words;
+
+		if (size > SIZE_MAX / sizeof(uint64_t))
+			return -1;
+
+		uint64_t *new_ = (uint64_t*)allocator_realloc(b->allocator, b->words,
+		                                              size * sizeof(uint64_t));
+		if (new_ == NULL)
+			return -1;
+
+		b->words = new_;
+		b->size  = size;
+	}
+
+	size_t old = BITSET_WORDS(b->bits);
+	if (words > old)
+		memset(b->words + old, 0, (words - old) * sizeof(uint64_t));
+
+	b->bits = bits;
+	bitset_mask_tail(b);
+	return 0;
+}
+
+void bitset_set_all(bitset_t *b) {
+	if (b->bits == 0)
+		return;
+
+	memset(b->words, 0xFF, BITSET_WORDS(b->bits) * sizeof(uint64_t));
+	bitset_mask_tail(b);
+}
+
+void bitset_clear_all(bitset_t *b) {
+	if (b->bits > 0)
+		memset(b->words, 0, BITSET_WORDS(b->bits) * sizeof(uint64_t));
+}
+
+size_t bitset_count(const bitset_t *b) {
+	size_t count = 0;
+	for (size_t i = 0; i < BITSET_WORDS(b->bits); ++ i)
+		count += bitset_popcount(b->words[i]);
+
+	return count;
+}
+
+size_t bitset_rank(const bitset_t *b, size_t idx) {
+	assert(idx <= b->bits);
+
+	size_t count = 0, full = idx / BITSET_WORD_BITS;
+	for (size_t i = 0; i < full; ++ i)
+		count += bitset_popcount(b->words[i]);
+
+	if (idx % BITSET_WORD_BITS != 0)
+		count += bitset_popcount(b->words[full] &
+		                         (((uint64_t)1 << (idx % BITSET_WORD_BITS)) - 1));
+
+	return count;
+}
+
+size_t bitset_find_next(const bitset_t *b, size_t from) {
+	if (from >= b->bits)
+		return BITSET_NPOS;
+
+	size_t   w    = from / BITSET_WORD_BITS, words = BITSET_WORDS(b->bits);
+	uint64_t word = b->words[w] & (~(uint64_t)0 << (from % BITSET_WORD_BITS));
+	while (word == 0) {
+		if (++ w >= words)
+			return BITSET_NPOS;
+
+		word = b->words[w];
+	}
+
+	return w * BITSET_WORD_BITS + bitset_ctz(word);
+}
+
+#define BITSET_AND(X, Y)    ((X) & (Y))
+#define BITSET_OR(X, Y)     ((X) | (Y))
+#define BITSET_XOR(X, Y)    ((X) ^ (Y))
+#define BITSET_ANDNOT(X, Y) ((X) & ~(Y))
+
+#if defined(__AVX2__)
+#	define BITSET_AND_SIMD(X, Y)    _mm256_and_si256(X, Y)
+#	define BITSET_OR_SIMD(X, Y)     _mm256_or_si256(X, Y)
+#	define BITSET_XOR_SIMD(X, Y)    _mm256_xor_si256(X, Y)
+#	define BITSET_ANDNOT_SIMD(X, Y) _mm256_andnot_si256(Y, X)
+
+#	define BITSET_SIMD_LOOP(D, S, N, I, OP) \
+		for (; I + 4 <= N; I += 4) { \
+			__m256i _x = _mm256_loadu_si256((const __m256i*)(D + I)); \
+			__m256i _y = _mm256_loadu_si256((const __m256i*)(S + I)); \
+			_mm256_storeu_si256((__m256i*)(D + I), OP(_x, _y)); \
+		}
+#elif defined(BITSET_SSE2)
+#	define BITSET_AND_SIMD(X, Y)    _mm_and_si128(X, Y)
+#	define BITSET_OR_SIMD(X, Y)     _mm_or_si128(X, Y)
+#	define BITSET_XOR_SIMD(X, Y)    _mm_xor_si128(X, Y)
+#	define BITSET_ANDNOT_SIMD(X, Y) _mm_andnot_si128(Y, X)
+
+#	define BITSET_SIMD_LOOP(D, S, N, I, OP) \
+		for (; I + 2 <= N; I += 2) { \
+			__m128i _x = _mm_loadu_si128((const __m128i*)(D + I)); \
+			__m128i _y = _mm_loadu_si128((const __m128i*)(S + I)); \
+			_mm_storeu_si128((__m128i*)(D + I), OP(_x, _y)); \
+		}
+#else
+#	define BITSET_SIMD_LOOP(D, S, N, I, OP)
+#endif
+
+#define BITSET_DEFINE_OP(NAME, OP) \
+	int NAME(bitset_t *dst, const bitset_t *src) { \
+		if (dst->bits != src->bits) \
+			return -1; \
+		\
+		uint64_t       *d = dst->words; \
+		const uint64_t *s = src->words; \
+		size_t          n = BITSET_WORDS(dst->bits), i = 0; \
+		BITSET_SIMD_LOOP(d, s, n, i, OP##_SIMD) \
+		for (; i < n; ++ i) \
+			d[i] = OP(d[i], s[i]); \
+		\
+		return 0; \
+	}
+
+BITSET_DEFINE_OP(bitset_and,    BITSET_AND)
+BITSET_DEFINE_OP(bitset_or,     BITSET_OR)
+BITSET_DEFINE_OP(bitset_xor,    BITSET_XOR)
+BITSET_DEFINE_OP(bitset_andnot, BITSET_ANDNOT)
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -1,8 +1,9 @@
 #include <string.h> /* strcmp */
 #include <malloc.h> /* free */
 
-#define SRC "examples"
-#define BIN "bin"
+#define SRC  "examples"
+#define BIN  "bin"
+#define LOGS BIN"/logs"
 
 #define CARGS "-O2", "-std=c99", "-Wall", "-Wextra", "-Werror", "-pedantic", \
               "-Wno-deprecated-declarations", "-I./"
@@ -15,6 +16,21 @@ char *cc = CC;
 void clean(void) {
 	bool found = false;
 	int  status;
+
+	/* Test logs */
+	if (fs_exists(LOGS)) {
+		FOREACH_VISIBLE_IN_DIR(LOGS, dir, ent, {
+			char *path = FS_JOIN_PATH(dir.path, ent.name);
+			if (path == NULL)
+				FATAL_FUNC_FAIL("malloc");
+
+			fs_remove_file(path);
+			free(path);
+		}, status);
+
+		fs_remove_dir(LOGS);
+	}
+
 	FOREACH_VISIBLE_IN_DIR(BIN, dir, ent, {
 		if (!found)
 			found = true;
@@ -25,9 +41,15 @@ void clean(void) {
 
 		fs_remove_file(path);
 		free(path);
+
+		/* Variant object directories, the PGO directory of 'bin' is cleaned below */
+		if (ent.attr & FS_DIR && strcmp(ent.name, BUILD_PGO_DIR) != 0)
+			build_clean_variant(BIN, ent.name);
 	}, status);
 
-	build_cache_delete();
+	if (build_clean_variant(BIN, NULL))
+		found = true;
+	fs_remove_file(BUILD_TEST_CACHE_PATH);
 
 	if (status != 0)
 		LOG_FATAL("Failed to open directory '%s'", BIN);
@@ -38,6 +60,27 @@ void clean(void) {
 		LOG_INFO("Cleaned '%s'", BIN);
 }
 
+bool build_example(build_cache_t *c, build_deps_t *deps, const char *src, const char *out) {
+	int64_t m_now;
+	if (fs_time(src, &m_now, NULL) != 0)
+		LOG_FATAL("Could not get last modified time of '%s'", src);
+
+	/* Rebuild the example if it or any library header it includes changed */
+	bool deps_changed = build_deps_changed(deps, c, src);
+	if (build_cache_get(c, src) == m_now && !deps_changed)
+		return false;
+
+	/* Examples that fail to compile are not marked as up to date, and neither are their headers */
+	const char *argv[] = {cc, src, "-o", out, CARGS, NULL};
+	if (cmd(argv) == 0) {
+		build_cache_set(c, src, m_now);
+		build_cache_save(c);
+	} else
+		build_deps_failed(deps, src);
+
+	return true;
+}
+
 void build(void) {
 	if (!fs_exists(BIN))
 		fs_create_dir(BIN);
@@ -45,6 +88,10 @@ void build(void) {
 	build_cache_t c;
 	build_cache_load(&c);
 
+	const char  *include_dirs[] = {"."};
+	build_deps_t deps;
+	build_deps_init(&deps, include_dirs, ARRAY_SIZE(include_dirs));
+
 	bool nothing_to_compile = true;
 
 	int status;
@@ -63,12 +110,9 @@ void build(void) {
 
 			free(out_name);
 
-			if (build_cache_update(&c, src)) {
-				CMD(cc, src, "-o", out, CARGS);
+			if (build_example(&c, &deps, src, out)) {
 				if (nothing_to_compile)
 					nothing_to_compile = false;
-
-				build_cache_save(&c);
 			}
 
 			free(out);
@@ -86,14 +130,117 @@ void build(void) {
 
 	if (nothing_to_compile)
 		LOG_INFO("Nothing to build");
+	else {
+		build_deps_update(&deps, &c);
+		build_cache_save(&c);
+	}
 
+	build_deps_free(&deps);
 	build_cache_free(&c);
 }
 
+/* Examples that need arguments, read files or are not expected to succeed */
+typedef struct {
+	const char *name;
+	const char *args[4];
+	const char *inputs[4];
+	int         exit_code;
+	bool        skip;
+} example_test_t;
+
+static example_test_t example_tests[] = {
+	{.name = "copy", .args = {"README", BIN"/README.copy"}, .inputs = {"README"}},
+	{.name = "ls",   .args = {SRC}},
+	{.name = "time", .inputs = {"README"}},
+	{.name = "log",  .exit_code = EXIT_FAILURE}, /* Shows off LOG_FATAL */
+	{.name = "link", .skip = true},              /* Creates a link in the working directory */
+};
+
+#define MAX_TESTS 128
+
+void test(void) {
+	build();
+
+	build_test_t tests[MAX_TESTS];
+	const char  *argvs[MAX_TESTS][ARRAY_SIZE(example_tests[0].args) + 2];
+	char        *names[MAX_TESTS];
+	size_t       count = 0;
+
+	/* Every example is a test */
+	int status;
+	FOREACH_VISIBLE_IN_DIR(SRC, dir, ent, {
+		char *path = FS_JOIN_PATH(dir.path, ent.name);
+		if (path == NULL)
+			FATAL_FUNC_FAIL("malloc");
+
+		int status;
+		FOREACH_VISIBLE_IN_DIR(path, dir, ent, {
+			assert(count < MAX_TESTS);
+
+			char *name = fs_remove_ext(ent.name);
+			if (name == NULL)
+				FATAL_FUNC_FAIL("malloc");
+
+			example_test_t *e = NULL;
+			for (size_t i = 0; i < ARRAY_SIZE(example_tests); ++ i) {
+				if (strcmp(example_tests[i].name, name) == 0)
+					e = &example_tests[i];
+			}
+
+			if (e != NULL && e->skip) {
+				free(name);
+				continue;
+			}
+
+			names[count] = FS_JOIN_PATH(BIN, name);
+			if (names[count] == NULL)
+				FATAL_FUNC_FAIL("malloc");
+
+			size_t argc = 0;
+			argvs[count][argc ++] = names[count];
+
+			build_test_t *t = &tests[count];
+			ZERO_STRUCT(*t);
+			t->name = fs_basename(names[count]);
+			t->argv = argvs[count];
+
+			if (e != NULL) {
+				for (size_t i = 0; i < ARRAY_SIZE(e->args) && e->args[i] != NULL; ++ i)
+					argvs[count][argc ++] = e->args[i];
+
+				while (t->inputs_count < ARRAY_SIZE(e->inputs) &&
+				       e->inputs[t->inputs_count] != NULL)
+					++ t->inputs_count;
+
+				t->inputs    = e->inputs;
+				t->exit_code = e->exit_code;
+			}
+
+			argvs[count][argc] = NULL;
+
+			free(name);
+			++ count;
+		}, status);
+
+		free(path);
+
+		if (status != 0)
+			LOG_FATAL("Failed to open directory '%s/%s'", SRC, ent.name);
+	}, status);
+
+	if (status != 0)
+		LOG_FATAL("Failed to open directory '%s'", SRC);
+
+	build_run_tests(tests, count, LOGS);
+
+	for (size_t i = 0; i < count; ++ i)
+		free(names[i]);
+}
+
 int main(int argc, const char **argv) {
 	args_t a = build_init(argc, argv);
 
-	build_set_usage("[clean] [OPTIONS]");
+	build_set_usage("[clean | test] [OPTIONS]");
 	flag_cstr(NULL, "CC", "The C compiler path", &cc);
 
 	args_t stripped;
@@ -108,6 +255,8 @@ int main(int argc, const char **argv) {
 
 		if (strcmp(subcmd, "clean") == 0)
 			clean();
+		else if (strcmp(subcmd, "test") == 0)
+			test();
 		else {
 			build_arg_error("Unknown subcommand '%s'", subcmd);
 			exit(EXIT_FAILURE);
@@ -116,5 +265,5 @@ int main(int argc, const char **argv) {
 		build();
 
 	free(stripped.base);
-	return EXIT_SUCCESS;
+	return build_report() > 0? EXIT_FAILURE : EXIT_SUCCESS;
 }
@@ -9,7 +9,7 @@
  * This library provides functions to write cross-platform (Windows, Unix/Linux) build files for
  * C/C++ projects. Heavily inspired by https://github.com/tsoding/nobuild
  *
- * Depends on cfs.h, clog.h, ccommon.h and cargs.h
+ * Depends on cfs.h, clog.h, ccommon.h, cargs.h and csv.h
  */
 
 /* Simple example of the library:
@@ -36,22 +36,25 @@ int main(int argc, const char **argv) {
 extern "C" {
 #endif
 
+/* Included first, so that its feature test macros apply to all of the system headers */
+#include "sys.h"
+
 #include <stdio.h>  /* FILE, stderr, fprintf, fopen, fclose, fgetc, EOF */
 #include <stdarg.h> /* va_list, va_start, va_end, vsnprintf */
 #include <assert.h> /* assert */
 #include <stdlib.h> /* exit, EXIT_FAILURE, EXIT_SUCCESS, malloc, realloc, free, atoll */
 #include <string.h> /* strcmp, memcpy */
-
-#include "sys.h"
+#include <errno.h>  /* errno, EINTR */
 
 #include "fs.h"
+#include "sv.h"
 #include "log.h"
 #include "args.h"
 #include "common.h"
 
 #define CHOL_BUILDER_VERSION_MAJOR 1
-#define CHOL_BUILDER_VERSION_MINOR 8
-#define CHOL_BUILDER_VERSION_PATCH 4
+#define CHOL_BUILDER_VERSION_MINOR 15
+#define CHOL_BUILDER_VERSION_PATCH 7
 
 /*
  * 1.0.0: Running commands (CMD and COMPILE macros), platform detection, embedding files
@@ -69,6 +72,23 @@ extern "C" {
  * 1.7.4: Rename build_multi_src_app to build_app, add build_app_config_t
  * 1.8.4: Added rebuild_all field to build_app_config_t, add build_cache_t optional parameter to
  *        build_app
+ * 1.9.4: Add profile-guided optimization mode to build_app, add build_cache_load_from, make
+ *        build_app skip linking when nothing was rebuilt
+ * 1.10.4: Add build variants with their own object directories and build caches, add build_apps
+ *         for building multiple variants in parallel
+ * 1.11.4: Add parallel compilation jobs, fail-fast and keep-going failure policies, cmd_async,
+ *         proc_wait, proc_kill and build_report, make cmd return the exit code
+ * 1.12.4: Add the #include scanner (build_deps_t), make build_app rebuild only the sources that
+ *         include a modified header
+ * 1.13.4: Add build_run_tests, a parallel test runner with timeouts and result caching
+ * 1.13.5: Fix 'pgo_retrain' not rebuilding the instrumented binary and not rerunning the training
+ * 1.13.6: Fix kill and SIGTERM being undeclared in the strict C modes
+ * 1.14.6: Add build_deps_failed, fix headers of sources that failed to compile being marked as up
+ *         to date
+ * 1.14.7: Fix cancelled variants leaving their link and PGO training commands running, fix build
+ *         jobs reaping the processes of cmd_async
+ * 1.15.7: Add build_clean_variant, fix build_clean leaving the profiles and the BUILD_PGO_DIR
+ *         directory behind
  */
 
 #if defined(WIN32)
@@ -88,6 +108,11 @@ extern "C" {
 #	define CXX "g++"
 #else
 #	include <unistd.h>
+#	include <signal.h>
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <sys/time.h>
 #	include <sys/types.h>
 #	include <sys/wait.h>
 
@@ -97,6 +122,11 @@ extern "C" {
 
 #define BUILD_APP_NAME   "./build"
 #define BUILD_CACHE_PATH ".chol_builder_cache"
+#define BUILD_PGO_DIR    "pgo"
+#define BUILD_PGO_APP    "{app}"
+
+#define BUILD_TEST_CACHE_PATH ".chol_builder_test_cache"
+#define BUILD_TEST_TIMEOUT    10.0
 
 void build_set_usage(const char *usage);
 void build_parse_args(args_t *a, args_t *stripped);
@@ -116,6 +146,20 @@ void build_arg_error(const char *fmt, ...);
  * BUILD_CACHE_PATH
  *     The path of the build cache file.
  *
+ * BUILD_PGO_DIR
+ *     Name of the directory (inside of the binary output directory) that build_app puts the
+ *     instrumented objects and binary of a profile-guided optimization build into.
+ *
+ * BUILD_PGO_APP
+ *     Placeholder argument of the profile-guided optimization training command, replaced with
+ *     the path of the instrumented binary.
+ *
+ * BUILD_TEST_CACHE_PATH
+ *     The path of the test results cache file.
+ *
+ * BUILD_TEST_TIMEOUT
+ *     The default test timeout in seconds.
+ *
  * void build_set_usage(const char *usage)
  *     Set the usage string to 'usage' (used by build_parse_args).
  *
@@ -135,10 +179,13 @@ typedef struct {
 typedef struct {
 	build_cache_item_t *buf;
 	size_t              count, size;
+
+	const char *path;
 } build_cache_t;
 
 int  build_cache_delete(void);
-int  build_cache_load(build_cache_t *c);
+int  build_cache_load(     build_cache_t *c);
+int  build_cache_load_from(build_cache_t *c, const char *path);
 int  build_cache_save(build_cache_t *c);
 void build_cache_free(build_cache_t *c);
 
@@ -150,14 +197,21 @@ int64_t build_cache_get(   build_cache_t *c, const char *path);
  * build_cache_t
  *     The build cache structure
  *
+ *     const char *path
+ *         Path of the file the cache was loaded from and is saved into
+ *
  * int build_cache_delete(void)
  *     Delete the build cache file. Returns 0 on success.
  *
  * int build_cache_load(build_cache_t *c)
  *     Load the build cache file into 'c'. Returns 0 on success, even if the file does not exist.
  *
+ * int build_cache_load_from(build_cache_t *c, const char *path)
+ *     Same as build_cache_load, except that the cache is loaded from file 'path' instead of
+ *     BUILD_CACHE_PATH. The string 'path' has to stay valid as long as 'c' is used.
+ *
  * int build_cache_save(build_cache_t *c)
- *     Save the build cache 'c' into the build cache file. Returns 0 on success.
+ *     Save the build cache 'c' into the file it was loaded from. Returns 0 on success.
  *
  * void build_cache_free(build_cache_t *c)
  *     Free the build cache 'c'. Returns 0 on success.
@@ -184,7 +238,7 @@ int64_t build_cache_get(   build_cache_t *c, const char *path);
 		compile(NAME, (const char **)SRCS, SRCS_COUNT, args, sizeof(args) / sizeof(args[0])); \
 	} while (0)
 
-void cmd(const char **argv);
+int  cmd(const char **argv);
 void compile(const char *compiler, const char **srcs, size_t srcs_count,
              const char **args, size_t args_count);
 
@@ -202,6 +256,138 @@ void compile(const char *compiler, const char **srcs, size_t srcs_count,
  *
  * The cmd and compile functions are what CMD and COMPILE respectively run. The functions take
  * arrays for arguments, so the macros exist to make the arrays for you and pass them in.
+ *
+ * When a command fails, what happens depends on the failure policy (see build_set_policy). In the
+ * fail-fast policy (default), all running jobs are killed and the program exits. In the
+ * keep-going policy, the failure is recorded for build_report and cmd returns the non-zero exit
+ * code.
+ */
+
+typedef struct {
+#ifdef BUILD_PLATFORM_WINDOWS
+	HANDLE handle;
+#else
+	pid_t pid;
+#endif
+} proc_t;
+
+proc_t cmd_async(const char **argv);
+int    proc_wait(proc_t p);
+void   proc_kill(proc_t p);
+
+/*
+ * proc_t
+ *     A running process
+ *
+ * proc_t cmd_async(const char **argv)
+ *     Start the command 'argv' (NULL terminated) without waiting for it to finish.
+ *
+ * int proc_wait(proc_t p)
+ *     Wait for process 'p' to finish and return its exit code (128 + the signal number on
+ *     Unix/Linux if it was killed by a signal).
+ *
+ * void proc_kill(proc_t p)
+ *     Kill the process 'p'. It still has to be waited for with proc_wait.
+ */
+
+enum {
+	BUILD_FAIL_FAST = 0,
+	BUILD_KEEP_GOING,
+};
+
+#ifndef BUILD_MAX_JOBS
+#	define BUILD_MAX_JOBS 64
+#endif
+
+void build_set_jobs(  size_t jobs);
+void build_set_policy(int policy);
+int  build_report(void);
+
+/*
+ * BUILD_FAIL_FAST
+ *     Failure policy that kills all running jobs and exits on the first failed command.
+ *
+ * BUILD_KEEP_GOING
+ *     Failure policy that finishes every job that does not depend on a failed one and records
+ *     the failures for build_report.
+ *
+ * BUILD_MAX_JOBS
+ *     The max count of jobs that can run in parallel. If not defined before including, the
+ *     default is 64.
+ *
+ * void build_set_jobs(size_t jobs)
+ *     Set the count of compilation jobs that build_app runs in parallel (default 1, also set by
+ *     the '-j' flag of build_parse_args).
+ *
+ * void build_set_policy(int policy)
+ *     Set the failure policy to 'policy' (default BUILD_FAIL_FAST, also set to BUILD_KEEP_GOING by
+ *     the '-k' flag of build_parse_args).
+ *
+ * int build_report(void)
+ *     Print a summary of all the commands that failed so far and return their count. Should be
+ *     called at the end of a build that uses the keep-going policy. Example:
+ *         | CMD(cc, "a.c", "-o", "a");
+ *         | CMD(cc, "b.c", "-o", "b");
+ *         | return build_report() > 0? EXIT_FAILURE : EXIT_SUCCESS;
+ */
+
+typedef struct {
+	char   *path;
+	size_t *includes;
+	size_t  includes_count;
+	int64_t mtime;
+	bool    changed, failed;
+	size_t  visit;
+} build_dep_t;
+
+typedef struct {
+	build_dep_t *buf;
+	size_t       count, size;
+
+	const char **dirs;
+	size_t       dirs_count;
+	size_t       visit;
+} build_deps_t;
+
+void build_deps_init(build_deps_t *d, const char **dirs, size_t dirs_count);
+void build_deps_free(build_deps_t *d);
+
+bool build_deps_changed(build_deps_t *d, build_cache_t *c, const char *src);
+void build_deps_failed( build_deps_t *d, const char *src);
+void build_deps_update( build_deps_t *d, build_cache_t *c);
+
+/*
+ * build_deps_t
+ *     The #include dependency scanner structure. Each scanned file is memory mapped and parsed
+ *     only once, its resolved includes are memoized.
+ *
+ *     const char **dirs
+ *         The directories to resolve includes against
+ *     size_t dirs_count
+ *         Count of elements in 'dirs'
+ *
+ * void build_deps_init(build_deps_t *d, const char **dirs, size_t dirs_count)
+ *     Initialize the scanner 'd' with 'dirs_count' include directories 'dirs'. '#include "..."'
+ *     is resolved against the directory of the including file first, then against 'dirs'.
+ *     '#include <...>' is only resolved against 'dirs', so system headers are ignored.
+ *     Includes that cannot be resolved are ignored.
+ *
+ * void build_deps_free(build_deps_t *d)
+ *     Free the scanner 'd'.
+ *
+ * bool build_deps_changed(build_deps_t *d, build_cache_t *c, const char *src)
+ *     Returns true if any header that 'src' includes (directly or indirectly) has a different
+ *     last modified time than in build cache 'c'. Does not modify 'c'.
+ *
+ * void build_deps_failed(build_deps_t *d, const char *src)
+ *     Mark all the headers that 'src' includes (directly or indirectly) as not up to date, so that
+ *     build_deps_update skips them and the sources that include them are rebuilt next time. Should
+ *     be called for each source that failed to compile, after build_deps_changed was called on it.
+ *
+ * void build_deps_update(build_deps_t *d, build_cache_t *c)
+ *     Set the last modified times of all the headers scanned by 'd' in build cache 'c', except
+ *     the ones marked by build_deps_failed. Should be called after the sources that depend on them
+ *     were rebuilt.
  */
 
 enum {
@@ -212,6 +398,7 @@ enum {
 void embed(const char *path, const char *out, int type);
 
 void build_clean(const char *path);
+bool build_clean_variant(const char *bin, const char *variant);
 
 typedef struct {
 	const char *src_ext, *header_ext;
@@ -221,10 +408,21 @@ typedef struct {
 	const char **srcs;
 	size_t       srcs_count;
 
+	const char **include_dirs;
+	size_t       include_dirs_count;
+
 	bool rebuild_all;
+
+	const char **pgo_train;
+	bool         pgo_retrain;
+
+	const char  *variant;
+	const char **flags;
+	size_t       flags_count;
 } build_app_config_t;
 
-void build_app(const char *compiler, build_app_config_t *config, build_cache_t *c);
+void build_app( const char *compiler, build_app_config_t *config, build_cache_t *c);
+void build_apps(const char *compiler, build_app_config_t *configs, size_t count);
 
 /*
  * build_app_config_t
@@ -233,7 +431,7 @@ void build_app(const char *compiler, build_app_config_t *config, build_cache_t *
  *     const char *src_ext
  *         Extension of a source file
  *     const char *header_ext
- *         Extension of a header file
+ *         Extension of a header file (unused, headers are found by scanning the sources)
  *     const char *bin
  *         The binary output directory
  *     const char *out
@@ -242,8 +440,25 @@ void build_app(const char *compiler, build_app_config_t *config, build_cache_t *
  *         Source files to compile
  *     size_t srcs_count
  *         Count of elements in 'srcs'
+ *     const char **include_dirs
+ *         Directories to resolve the includes of the sources against (see build_deps_init)
+ *     size_t include_dirs_count
+ *         Count of elements in 'include_dirs'
  *     bool rebuild_all
  *         Rebuild all source files
+ *     const char **pgo_train
+ *         NULL terminated training command of a profile-guided optimization build. If NULL,
+ *         the app is built normally
+ *     bool pgo_retrain
+ *         Rebuild the instrumented binary and rerun the training command, even if a profile
+ *         already exists
+ *     const char *variant
+ *         Name of the build variant. If not NULL, the objects are put into the directory
+ *         'variant' inside of 'bin', which also contains the build cache of the variant
+ *     const char **flags
+ *         Extra compilation arguments of this config (for example "-g" for a debug variant)
+ *     size_t flags_count
+ *         Count of elements in 'flags'
  *
  * STRING_ARRAY
  *     Embed file as a string array (const char*[])
@@ -259,7 +474,14 @@ void build_app(const char *compiler, build_app_config_t *config, build_cache_t *
  *         | #include "my_embed.h"
  *
  * void build_clean(const char *path)
- *     Function for common cleaning functionality. Cleans all .o files from directory 'path'.
+ *     Function for common cleaning functionality. Cleans all .o and .gcda files from directory
+ *     'path', the BUILD_PGO_DIR directory inside of it and the build cache.
+ *
+ * bool build_clean_variant(const char *bin, const char *variant)
+ *     Removes the objects, profiles, build cache and BUILD_PGO_DIR directory of the variant
+ *     'variant' built into 'bin', and the variant object directory if it is left empty. If
+ *     'variant' is NULL, the files of the build without a variant are removed from 'bin' and
+ *     the global build cache is deleted. Returns true if anything was removed.
  *
  * void build_app(const char *compiler, build_app_config_t *config, build_cache_t *c)
  *     A wrapper to provide common build.c functionality in a single function call. Example:
@@ -275,6 +497,93 @@ void build_app(const char *compiler, build_app_config_t *config, build_cache_t *
  *     the extra arguments to run on compilation, and 'CLIBS' are the library linking arguments.
  *     To use these "extra parameters", simply define the 'CARGS' and 'CLIBS' macros. If they
  *     arent defined, they will be defined as empty macros.
+ *
+ *     If 'pgo_train' is set, the app is built with GCC-style profile-guided optimization in 3
+ *     stages:
+ *       1. The sources are compiled with '-fprofile-generate' into the BUILD_PGO_DIR directory
+ *          inside of 'bin', which has its own build cache.
+ *       2. The training command 'pgo_train' is run, with every BUILD_PGO_APP argument replaced by
+ *          the path of the instrumented binary. Example:
+ *              | const char *train[] = {BUILD_PGO_APP, "--bench", "data.txt", NULL};
+ *              | config.pgo_train = train;
+ *       3. The profiles are copied into 'bin' and the sources are rebuilt with '-fprofile-use'.
+ *
+ *     Stages 1 and 2 only run if there is no profile yet or if 'pgo_retrain' is set, so code
+ *     changes reuse the existing profile. Objects of stage 3 are rebuilt when their source or
+ *     the profile changes. Switching an already built app to or from profile-guided optimization
+ *     requires 'rebuild_all' to be set.
+ *
+ *     A source is rebuilt when it or any header it includes was modified, the headers are found
+ *     with the #include scanner (build_deps_t) without invoking the compiler.
+ *
+ *     The objects are compiled by up to build_set_jobs jobs in parallel. Objects that fail to
+ *     compile are not marked as up to date in the build cache, and the app is not linked if any of
+ *     them failed. In the keep-going policy, build_app prints the build_report summary and exits
+ *     after every object was compiled if there were any failures.
+ *
+ *     If 'variant' is set, the build cache of the variant is used instead of 'c' when 'c' is
+ *     NULL, and the BUILD_PGO_DIR directory is put into the variant object directory.
+ *
+ * void build_apps(const char *compiler, build_app_config_t *configs, size_t count)
+ *     Build 'count' configs from 'configs' with build_app in parallel (each one in its own
+ *     process, on Windows they are built one after another). In the fail-fast policy, the first
+ *     variant that fails kills all the others. Each config should have its own
+ *     'variant' and 'out', so that the builds do not share object files or build caches.
+ *     Example:
+ *         | const char *debug[]   = {"-g", "-O0"};
+ *         | const char *release[] = {"-O2", "-DNDEBUG"};
+ *         | build_app_config_t configs[] = {
+ *         |     {.src_ext = "c", .header_ext = "h", .bin = BIN, .out = BIN"/app-debug",
+ *         |      .srcs = srcs, .srcs_count = ARRAY_SIZE(srcs),
+ *         |      .variant = "debug", .flags = debug, .flags_count = ARRAY_SIZE(debug)},
+ *         |     {.src_ext = "c", .header_ext = "h", .bin = BIN, .out = BIN"/app",
+ *         |      .srcs = srcs, .srcs_count = ARRAY_SIZE(srcs),
+ *         |      .variant = "release", .flags = release, .flags_count = ARRAY_SIZE(release)},
+ *         | };
+ *         | build_apps(cc, configs, ARRAY_SIZE(configs));
+ */
+
+typedef struct {
+	const char  *name;
+	const char **argv;
+	const char **inputs;
+	size_t       inputs_count;
+	int          exit_code;
+	double       timeout;
+} build_test_t;
+
+size_t build_run_tests(build_test_t *tests, size_t count, const char *log_dir);
+
+/*
+ * build_test_t
+ *     Test structure for the build_run_tests function
+ *
+ *     const char *name
+ *         Name of the test (has to be unique, it is used for the log file and the results cache)
+ *     const char **argv
+ *         NULL terminated command of the test, where the first argument is the test binary
+ *     const char **inputs
+ *         Files that the test reads, modifying them reruns the test
+ *     size_t inputs_count
+ *         Count of elements in 'inputs'
+ *     int exit_code
+ *         The exit code the test is expected to exit with
+ *     double timeout
+ *         Timeout of the test in seconds. If 0, BUILD_TEST_TIMEOUT is used
+ *
+ * size_t build_run_tests(build_test_t *tests, size_t count, const char *log_dir)
+ *     Run 'count' tests from 'tests', up to build_set_jobs of them in parallel. The output of each
+ *     test is captured into the file '<log_dir>/<name>.log' and printed if the test fails. Tests
+ *     that run longer than their timeout are killed and fail. The duration of every test is
+ *     reported. A test whose binary and inputs have not been modified since it last passed is
+ *     skipped (the results are cached in BUILD_TEST_CACHE_PATH). Failed tests are recorded for
+ *     build_report. Returns the count of failed tests. Example:
+ *         | const char *argv[]   = {"bin/parse", "tests/input.txt", NULL};
+ *         | const char *inputs[] = {"tests/input.txt"};
+ *         | build_test_t tests[] = {
+ *         |     {.name = "parse", .argv = argv, .inputs = inputs, .inputs_count = 1},
+ *         | };
+ *         | build_run_tests(tests, ARRAY_SIZE(tests), "bin/logs");
  */
 
 #ifdef __cplusplus
@@ -299,8 +608,13 @@ extern "C" {
 #define CHOL_COMMON_IMPLEMENTATION
 #include "common.h"
 
-static bool _build_help = false;
-static bool _build_ver  = false;
+#define CHOL_SV_IMPLEMENTATION
+#include "sv.h"
+
+static bool   _build_help       = false;
+static bool   _build_ver        = false;
+static bool   _build_keep_going = false;
+static size_t _build_jobs_flag  = 1;
 
 static const char *_build_usage = "[OPTIONS]";
 
@@ -310,6 +624,9 @@ args_t build_init(int argc, const char **argv) {
 
 	flag_bool("h", "help",    "Show the usage",   &_build_help);
 	flag_bool("v", "version", "Show the version", &_build_ver);
+	flag_size("j", "jobs",    "Count of parallel compilation jobs",         &_build_jobs_flag);
+	flag_bool("k", "keep-going", "Keep building independent jobs after a failure",
+	          &_build_keep_going);
 
 	log_set_flags(LOG_TIME);
 
@@ -355,24 +672,127 @@ void build_parse_args(args_t *a, args_t *stripped) {
 		       CHOL_BUILDER_VERSION_MAJOR, CHOL_BUILDER_VERSION_MINOR, CHOL_BUILDER_VERSION_PATCH);
 		exit(EXIT_SUCCESS);
 	}
+
+	build_set_jobs(_build_jobs_flag);
+	build_set_policy(_build_keep_going? BUILD_KEEP_GOING : BUILD_FAIL_FAST);
 }
 
-void cmd(const char **argv) {
-	size_t count     = 0;
-	char   buf[1024] = {0};
+static size_t _build_jobs   = 1;
+static int    _build_policy = BUILD_FAIL_FAST;
 
-	bool first = true;
+typedef void (*build_job_done_t)(void *data, bool ok);
+
+typedef struct {
+	proc_t           proc;
+	char            *cmd;
+	build_job_done_t done;
+	void            *data;
+} build_job_t;
+
+static build_job_t _build_running[BUILD_MAX_JOBS];
+static size_t      _build_running_count = 0;
+
+typedef struct {
+	char *cmd;
+	int   code;
+} build_failure_t;
+
+static build_failure_t *_build_failures       = NULL;
+static size_t           _build_failures_count = 0, _build_failures_size = 0;
+
+void build_set_jobs(size_t jobs) {
+	_build_jobs = jobs == 0? 1 : jobs;
+	if (_build_jobs > BUILD_MAX_JOBS)
+		_build_jobs = BUILD_MAX_JOBS;
+}
+
+void build_set_policy(int policy) {
+	_build_policy = policy;
+}
+
+int build_report(void) {
+	if (_build_failures_count == 0)
+		return 0;
+
+	LOG_ERROR("%zu command(s) failed:", _build_failures_count);
+	for (size_t i = 0; i < _build_failures_count; ++ i)
+		fprintf(stderr, "  [exitcode %i] %s\n", _build_failures[i].code, _build_failures[i].cmd);
+
+	return (int)_build_failures_count;
+}
+
+static char *build_cmd_str(const char **argv) {
+	size_t len = 1;
+	for (const char **next = argv; *next != NULL; ++ next)
+		len += strlen(*next) + 1;
+
+	char *str = (char*)malloc(len);
+	if (str == NULL)
+		FATAL_FUNC_FAIL("malloc");
+
+	str[0] = '\0';
 	for (const char **next = argv; *next != NULL; ++ next) {
-		if (first)
-			first = false;
-		else
-			strcat(buf, " ");
+		if (next != argv)
+			strcat(str, " ");
 
-		strcat(buf, *next);
-		++ count;
+		strcat(str, *next);
+	}
+
+	return str;
+}
+
+static void build_kill_running(void) {
+	for (size_t i = 0; i < _build_running_count; ++ i)
+		proc_kill(_build_running[i].proc);
+
+	for (size_t i = 0; i < _build_running_count; ++ i) {
+		proc_wait(_build_running[i].proc);
+		free(_build_running[i].cmd);
+	}
+
+	if (_build_running_count > 0)
+		LOG_WARN("Killed %zu running job(s)", _build_running_count);
+
+	_build_running_count = 0;
+}
+
+/* Takes the ownership of 'cmd' */
+static void build_record_failure(char *cmd, int code) {
+	if (_build_failures_count >= _build_failures_size) {
+		_build_failures_size = _build_failures_size == 0? 16 : _build_failures_size * 2;
+		void *ptr = realloc(_build_failures, _build_failures_size * sizeof(*_build_failures));
+		if (ptr == NULL)
+			FATAL_FUNC_FAIL("realloc");
+
+		_build_failures = (build_failure_t*)ptr;
 	}
 
-	LOG_CUSTOM("CMD", "%s", buf);
+	_build_failures[_build_failures_count].cmd  = cmd;
+	_build_failures[_build_failures_count].code = code;
+	++ _build_failures_count;
+}
+
+/* Takes the ownership of 'cmd' */
+static void build_fail(char *cmd, int code) {
+	if (_build_policy == BUILD_FAIL_FAST) {
+		build_kill_running();
+		LOG_FATAL("Command '%s' exited with exitcode '%i'", cmd, code);
+	}
+
+	LOG_ERROR("Command '%s' exited with exitcode '%i'", cmd, code);
+	build_record_failure(cmd, code);
+}
+
+proc_t cmd_async(const char **argv) {
+	char *str = build_cmd_str(argv);
+	LOG_CUSTOM("CMD", "%s", str);
+	free(str);
+
+	proc_t p;
+
+	/* Flush the output so the child does not inherit unwritten buffers */
+	fflush(stdout);
+	fflush(stderr);
 
 #ifdef BUILD_PLATFORM_WINDOWS
 	STARTUPINFO si;
@@ -382,14 +802,17 @@ void cmd(const char **argv) {
 	memset(&pi, 0, sizeof(pi));
 	si.cb = sizeof(si);
 
-	size_t len      = strlen(buf) + count * 2;
-	char  *cmd_line = (char*)malloc(len);
+	size_t len = 1;
+	for (const char **next = argv; *next != NULL; ++ next)
+		len += strlen(*next) + 3;
+
+	char *cmd_line = (char*)malloc(len);
 	if (cmd_line == NULL)
 		FATAL_FUNC_FAIL("malloc");
 
 	memset(cmd_line, 0, len);
 
-	first = true;
+	bool first = true;
 	for (const char **next = argv; *next != NULL; ++ next) {
 		if (first) {
 			strcat(cmd_line, *next);
@@ -402,38 +825,168 @@ void cmd(const char **argv) {
 		}
 	}
 
-	LOG_INFO("%s", cmd_line);
-
 	if (!CreateProcessA(NULL, cmd_line, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi))
 		LOG_FATAL("Could not execute command '%s' %d", argv[0], GetLastError());
 
-	WaitForSingleObject(pi.hProcess, INFINITE);
 	free(cmd_line);
+	CloseHandle(pi.hThread);
+
+	p.handle = pi.hProcess;
+#else
+	p.pid = fork();
+	if (p.pid == 0) {
+		execvp(argv[0], (char**)argv);
+
+		LOG_ERROR("Could not execute command '%s'", argv[0]);
+		_exit(127);
+	} else if (p.pid == -1)
+		FATAL_FUNC_FAIL("fork");
+#endif
+
+	return p;
+}
+
+int proc_wait(proc_t p) {
+#ifdef BUILD_PLATFORM_WINDOWS
+	WaitForSingleObject(p.handle, INFINITE);
 
 	DWORD status;
-	GetExitCodeProcess(pi.hProcess, &status);
+	GetExitCodeProcess(p.handle, &status);
+	CloseHandle(p.handle);
 
-	CloseHandle(pi.hProcess);
-	CloseHandle(pi.hThread);
+	return (int)status;
+#else
+	int status;
+	while (waitpid(p.pid, &status, 0) == -1) {
+		if (errno != EINTR)
+			FATAL_FUNC_FAIL("waitpid");
+	}
 
-	if (status != 0)
-		LOG_FATAL("Command '%s' exited with exitcode '%i'", argv[0], status);
+	if (WIFSIGNALED(status))
+		return 128 + WTERMSIG(status);
+
+	return WEXITSTATUS(status);
+#endif
+}
+
+void proc_kill(proc_t p) {
+#ifdef BUILD_PLATFORM_WINDOWS
+	TerminateProcess(p.handle, EXIT_FAILURE);
 #else
-	pid_t pid_ = fork();
-	if (pid_ == 0) {
-		if (execvp(argv[0], (char**)argv) == -1)
-			LOG_FATAL("Could not execute command '%s'", argv[0]);
+	kill(p.pid, SIGTERM);
+#endif
+}
 
-		exit(EXIT_SUCCESS);
-	} else if (pid_ == -1)
-		FATAL_FUNC_FAIL("fork");
-	else {
-		int status;
-		pid_ = wait(&status);
-		if (status != 0)
-			LOG_FATAL("Command '%s' exited with exitcode '%i'", argv[0], status);
+#ifndef BUILD_PLATFORM_WINDOWS
+/* The child of the blocking cmd call, killed by build_variant_terminate along with the jobs */
+static volatile sig_atomic_t _build_cmd_pid = 0;
+#endif
+
+int cmd(const char **argv) {
+	proc_t p = cmd_async(argv);
+#ifndef BUILD_PLATFORM_WINDOWS
+	_build_cmd_pid = p.pid;
+#endif
+
+	int code = proc_wait(p);
+#ifndef BUILD_PLATFORM_WINDOWS
+	_build_cmd_pid = 0;
+#endif
+
+	if (code != 0)
+		build_fail(build_cmd_str(argv), code);
+
+	return code;
+}
+
+static void build_sleep_ms(unsigned ms) {
+#ifdef BUILD_PLATFORM_WINDOWS
+	Sleep(ms);
+#else
+	usleep(ms * 1000);
+#endif
+}
+
+/* Returns true and sets 'code' if process 'p' finished, does not block */
+static bool build_proc_poll(proc_t p, int *code) {
+#ifdef BUILD_PLATFORM_WINDOWS
+	if (WaitForSingleObject(p.handle, 0) != WAIT_OBJECT_0)
+		return false;
+
+	*code = proc_wait(p);
+	return true;
+#else
+	int   status;
+	pid_t pid = waitpid(p.pid, &status, WNOHANG);
+	if (pid == 0 || (pid == -1 && errno == EINTR))
+		return false;
+	else if (pid == -1)
+		FATAL_FUNC_FAIL("waitpid");
+
+	*code = WIFSIGNALED(status)? 128 + WTERMSIG(status) : WEXITSTATUS(status);
+	return true;
+#endif
+}
+
+/* Wait for any running job to finish, and remove it from the running jobs */
+static void build_job_wait_any(void) {
+	assert(_build_running_count > 0);
+
+	size_t idx  = 0;
+	int    code = 0;
+
+#ifdef BUILD_PLATFORM_WINDOWS
+	HANDLE handles[BUILD_MAX_JOBS];
+	for (size_t i = 0; i < _build_running_count; ++ i)
+		handles[i] = _build_running[i].proc.handle;
+
+	DWORD ret = WaitForMultipleObjects((DWORD)_build_running_count, handles, FALSE, INFINITE);
+	if (ret == WAIT_FAILED)
+		FATAL_FUNC_FAIL("WaitForMultipleObjects");
+
+	idx  = (size_t)(ret - WAIT_OBJECT_0);
+	code = proc_wait(_build_running[idx].proc);
+#else
+	/* Only the jobs are waited for, waitpid(-1) would also reap the processes of cmd_async */
+	for (;;) {
+		for (idx = 0; idx < _build_running_count; ++ idx) {
+			if (build_proc_poll(_build_running[idx].proc, &code))
+				break;
+		}
+
+		if (idx < _build_running_count)
+			break;
+
+		build_sleep_ms(1);
 	}
 #endif
+
+	build_job_t job = _build_running[idx];
+	_build_running[idx] = _build_running[-- _build_running_count];
+
+	if (job.done != NULL)
+		job.done(job.data, code == 0);
+
+	if (code != 0)
+		build_fail(job.cmd, code);
+	else
+		free(job.cmd);
+}
+
+static void build_job_start(const char **argv, build_job_done_t done, void *data) {
+	while (_build_running_count >= _build_jobs)
+		build_job_wait_any();
+
+	build_job_t *job = &_build_running[_build_running_count ++];
+	job->cmd  = build_cmd_str(argv);
+	job->done = done;
+	job->data = data;
+	job->proc = cmd_async(argv);
+}
+
+static void build_job_wait_all(void) {
+	while (_build_running_count > 0)
+		build_job_wait_any();
 }
 
 void compile(const char *compiler, const char **srcs, size_t srcs_count,
@@ -555,6 +1108,11 @@ int build_cache_delete(void) {
 }
 
 int build_cache_load(build_cache_t *c) {
+	return build_cache_load_from(c, BUILD_CACHE_PATH);
+}
+
+int build_cache_load_from(build_cache_t *c, const char *path) {
+	c->path  = path;
 	c->count = 0;
 	c->size  = 16;
 	c->buf   = (build_cache_item_t*)malloc(c->size * sizeof(*c->buf));
@@ -562,7 +1120,7 @@ int build_cache_load(build_cache_t *c) {
 		FATAL_FUNC_FAIL("malloc");
 
 	/* If the build cache file exists, read it into the build cache structure */
-	FILE *f = fopen(BUILD_CACHE_PATH, "r");
+	FILE *f = fopen(path, "r");
 	if (f != NULL) {
 		char line[PATH_MAX] = {0};
 		while (fgets(line, PATH_MAX, f) != NULL) {
@@ -599,7 +1157,7 @@ int build_cache_load(build_cache_t *c) {
 }
 
 int build_cache_save(build_cache_t *c) {
-	FILE *f = fopen(BUILD_CACHE_PATH, "w");
+	FILE *f = fopen(c->path, "w");
 	if (f == NULL)
 		return -1;
 
@@ -656,120 +1214,511 @@ int64_t build_cache_get(build_cache_t *c, const char *path) {
 	return (int64_t)-1;
 }
 
-void build_clean(const char *path) {
-	bool found = false;
-	int  status;
-	FOREACH_IN_DIR(path, dir, ent, {
-		if (strcmp(fs_ext(ent.name), "o") != 0)
-			continue;
+void build_deps_init(build_deps_t *d, const char **dirs, size_t dirs_count) {
+	d->count = 0;
+	d->size  = 16;
+	d->buf   = (build_dep_t*)malloc(d->size * sizeof(*d->buf));
+	if (d->buf == NULL)
+		FATAL_FUNC_FAIL("malloc");
 
-		if (!found)
-			found = true;
+	d->dirs       = dirs;
+	d->dirs_count = dirs_count;
+	d->visit      = 0;
+}
 
-		char *path = FS_JOIN_PATH(dir.path, ent.name);
-		if (path == NULL)
-			FATAL_FUNC_FAIL("malloc");
+void build_deps_free(build_deps_t *d) {
+	for (size_t i = 0; i < d->count; ++ i) {
+		free(d->buf[i].path);
+		free(d->buf[i].includes);
+	}
 
-		fs_remove_file(path);
-		free(path);
-	}, status);
+	free(d->buf);
+	d->buf   = NULL;
+	d->count = 0;
+	d->size  = 0;
+}
 
-	if (status != 0)
-		LOG_FATAL("Failed to open directory '%s'", path);
+/* Returns the index of 'path' in 'd', adding it if it is not there yet. Takes the ownership of
+   'path' */
+static size_t build_deps_get(build_deps_t *d, char *path) {
+	for (size_t i = 0; i < d->count; ++ i) {
+		if (strcmp(d->buf[i].path, path) == 0) {
+			free(path);
+			return i;
+		}
+	}
 
-	build_cache_delete();
+	if (d->count >= d->size) {
+		d->size *= 2;
+		void *ptr = realloc(d->buf, d->size * sizeof(*d->buf));
+		if (ptr == NULL)
+			FATAL_FUNC_FAIL("realloc");
 
-	if (!found)
-		LOG_INFO("Nothing to clean");
-	else
-		LOG_INFO("Cleaned '%s'", path);
+		d->buf = (build_dep_t*)ptr;
+	}
+
+	build_dep_t *dep    = &d->buf[d->count];
+	dep->path           = path;
+	dep->includes       = NULL;
+	dep->includes_count = 0;
+	dep->mtime          = -1;
+	dep->changed        = false;
+	dep->failed         = false;
+	dep->visit          = (size_t)-1;
+	return d->count ++;
 }
 
-/* Macros that have to be defined for this function */
-#ifndef CARGS
-#	define CARGS
-#endif
+/* Returns the path of 'name' included from 'from', or NULL if it could not be resolved */
+static char *build_deps_resolve(build_deps_t *d, const char *from, sv_t name, bool quoted) {
+	char buf[PATH_MAX];
+	if (name.len >= sizeof(buf))
+		return NULL;
+
+	memcpy(buf, name.cstr, name.len);
+	buf[name.len] = '\0';
+
+	if (quoted) {
+		/* Relative to the directory of the including file */
+		const char *base = fs_basename(from);
+		if (base != from) {
+			size_t len = (size_t)(base - from);
+			if (len + name.len < sizeof(buf)) {
+				char path[PATH_MAX];
+				memcpy(path, from, len);
+				memcpy(path + len, buf, name.len + 1);
+
+				if (fs_exists(path))
+					return strcpy_to_heap(path);
+			}
+		} else if (fs_exists(buf))
+			return strcpy_to_heap(buf);
+	}
 
-#ifndef CLIBS
-#	define CLIBS
-#endif
+	for (size_t i = 0; i < d->dirs_count; ++ i) {
+		char *path = FS_JOIN_PATH(d->dirs[i], buf);
+		if (path == NULL)
+			FATAL_FUNC_FAIL("malloc");
 
-static char *build_file(const char *cc, build_cache_t *c, const char *out_dir, const char *src_dir,
-                        const char *src_name, bool force_rebuild) {
-	/* Get the object file and source file paths */
-	char *out_name = fs_replace_ext(src_name, "o");
-	if (out_name == NULL)
-		FATAL_FUNC_FAIL("malloc");
+		if (fs_exists(path))
+			return path;
 
-	char *out = FS_JOIN_PATH(out_dir, out_name);
-	char *src = FS_JOIN_PATH(src_dir, src_name);
-	if (out_name == NULL || out == NULL || src == NULL)
-		FATAL_FUNC_FAIL("malloc");
+		free(path);
+	}
 
-	free(out_name);
+	return NULL;
+}
 
-	/* Compile if the file needs to be compiled */
-	int64_t m_cached = build_cache_get(c, src);
-	int64_t m_now;
-	if (fs_time(src, &m_now, NULL) != 0)
-		LOG_FATAL("Could not get last modified time of '%s'", src);
+static void build_deps_add_include(build_deps_t *d, size_t idx, size_t include) {
+	build_dep_t *dep = &d->buf[idx];
 
-	if (m_cached != m_now || force_rebuild) {
-		build_cache_set(c, src, m_now);
-		CMD(cc, "-c", src, "-o", out, CARGS);
-	}
+	void *ptr = realloc(dep->includes, (dep->includes_count + 1) * sizeof(*dep->includes));
+	if (ptr == NULL)
+		FATAL_FUNC_FAIL("realloc");
 
-	free(src);
-	return out;
+	dep->includes = (size_t*)ptr;
+	dep->includes[dep->includes_count ++] = include;
 }
 
-void build_app(const char *compiler, build_app_config_t *config, build_cache_t *c) {
-	if (!fs_exists(config->bin))
-		fs_create_dir(config->bin);
+static void build_deps_parse(build_deps_t *d, size_t idx, sv_t src) {
+	while (src.len > 0) {
+		size_t end  = sv_find_first(src, '\n');
+		sv_t   line = sv_substr(src, 0, end == SV_NPOS? src.len : end);
+		src = end == SV_NPOS? sv_substr(src, src.len, 0) : sv_substr(src, end + 1, SV_NPOS);
 
-	char  *o_files[128];
-	size_t o_files_count = 0;
+		line = sv_trim_front(line, " \t");
+		if (!sv_has_prefix(line, sv_cstr("#")))
+			continue;
 
-	build_cache_t c_;
-	bool create_build_cache_struct = c == NULL;
-	if (create_build_cache_struct) {
-		if (build_cache_load(&c_) != 0)
-			LOG_FATAL("Build cache is corrupted");
-		c = &c_;
+		line = sv_trim_front(sv_substr(line, 1, SV_NPOS), " \t");
+		if (!sv_has_prefix(line, sv_cstr("include")))
+			continue;
+
+		line = sv_trim_front(sv_substr(line, 7, SV_NPOS), " \t");
+		if (line.len == 0 || (line.cstr[0] != '"' && line.cstr[0] != '<'))
+			continue;
+
+		bool   quoted = line.cstr[0] == '"';
+		size_t close  = sv_find_first(sv_substr(line, 1, SV_NPOS), quoted? '"' : '>');
+		if (close == SV_NPOS)
+			continue;
+
+		char *path = build_deps_resolve(d, d->buf[idx].path, sv_substr(line, 1, close), quoted);
+		if (path != NULL) {
+			/* build_deps_get can move the buffer, so the index is used instead of a pointer */
+			size_t include = build_deps_get(d, path);
+			build_deps_add_include(d, idx, include);
+		}
 	}
+}
 
-	bool rebuild_all = config->rebuild_all;
+/* Memory map the file of 'd->buf[idx]' and parse its includes */
+static void build_deps_scan(build_deps_t *d, size_t idx) {
+	const char *path = d->buf[idx].path;
 
-	/* Compile files in all source directories */
-	for (size_t i = 0; i < config->srcs_count; ++ i) {
-		int status;
+#ifdef BUILD_PLATFORM_WINDOWS
+	HANDLE f = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+	if (f == INVALID_HANDLE_VALUE)
+		return;
 
-		/* If a header file was modified, everything needs to be rebuilt. Check for that here */
-		FOREACH_IN_DIR(config->srcs[i], dir, ent, {
-			if (strcmp(fs_ext(ent.name), config->header_ext) != 0)
-				continue;
+	DWORD size = GetFileSize(f, NULL);
+	if (size == 0 || size == INVALID_FILE_SIZE) {
+		CloseHandle(f);
+		return;
+	}
 
-			char *src = FS_JOIN_PATH(config->srcs[i], ent.name);
-			if (src == NULL)
-				FATAL_FUNC_FAIL("malloc");
+	HANDLE map = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (map == NULL) {
+		CloseHandle(f);
+		return;
+	}
 
-			int64_t m_cached = build_cache_get(c, src);
-			int64_t m_now;
-			if (fs_time(src, &m_now, NULL) != 0)
-				LOG_FATAL("Could not get last modified time of '%s'", src);
+	const char *data = (const char*)MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+	if (data != NULL) {
+		build_deps_parse(d, idx, sv_new(data, (size_t)size));
+		UnmapViewOfFile(data);
+	}
 
-			if (m_cached != m_now) {
-				if (!rebuild_all)
-					rebuild_all = true;
+	CloseHandle(map);
+	CloseHandle(f);
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return;
 
-				build_cache_set(c, src, m_now);
-			}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		return;
+	}
 
-			free(src);
-		}, status);
+	size_t size = (size_t)st.st_size;
+	void  *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return;
 
-		if (status != 0)
-			LOG_FATAL("Failed to open directory '%s'", config->srcs[i]);
+	build_deps_parse(d, idx, sv_new((const char*)data, size));
+	munmap(data, size);
+#endif
+}
+
+static bool build_deps_visit(build_deps_t *d, build_cache_t *c, size_t idx) {
+	d->buf[idx].visit = d->visit;
+
+	/* Scan each file only once, the includes and the modification state are memoized */
+	if (d->buf[idx].mtime == -1) {
+		if (fs_time(d->buf[idx].path, &d->buf[idx].mtime, NULL) != 0)
+			LOG_FATAL("Could not get last modified time of '%s'", d->buf[idx].path);
+
+		d->buf[idx].changed = build_cache_get(c, d->buf[idx].path) != d->buf[idx].mtime;
+		build_deps_scan(d, idx);
+	}
+
+	/* Every reachable header is visited, even after a change was found, so that
+	   build_deps_update marks all of them */
+	bool changed = d->buf[idx].changed;
+	for (size_t i = 0; i < d->buf[idx].includes_count; ++ i) {
+		size_t include = d->buf[idx].includes[i];
+		if (d->buf[include].visit == d->visit)
+			continue;
+
+		if (build_deps_visit(d, c, include))
+			changed = true;
+	}
+
+	return changed;
+}
+
+bool build_deps_changed(build_deps_t *d, build_cache_t *c, const char *src) {
+	char *path = strcpy_to_heap(src);
+	if (path == NULL)
+		FATAL_FUNC_FAIL("malloc");
+
+	size_t idx = build_deps_get(d, path);
+	++ d->visit;
+
+	/* The source itself is tracked by the caller, only its includes matter */
+	bool changed = false;
+	d->buf[idx].visit = d->visit;
+	if (d->buf[idx].mtime == -1) {
+		if (fs_time(src, &d->buf[idx].mtime, NULL) != 0)
+			LOG_FATAL("Could not get last modified time of '%s'", src);
+
+		build_deps_scan(d, idx);
+	}
+
+	for (size_t i = 0; i < d->buf[idx].includes_count; ++ i) {
+		size_t include = d->buf[idx].includes[i];
+		if (d->buf[include].visit == d->visit)
+			continue;
+
+		if (build_deps_visit(d, c, include))
+			changed = true;
+	}
+
+	return changed;
+}
+
+static void build_deps_mark_failed(build_deps_t *d, size_t idx) {
+	d->buf[idx].visit = d->visit;
+
+	for (size_t i = 0; i < d->buf[idx].includes_count; ++ i) {
+		size_t include = d->buf[idx].includes[i];
+		if (d->buf[include].visit == d->visit)
+			continue;
+
+		d->buf[include].failed = true;
+		build_deps_mark_failed(d, include);
+	}
+}
+
+void build_deps_failed(build_deps_t *d, const char *src) {
+	char *path = strcpy_to_heap(src);
+	if (path == NULL)
+		FATAL_FUNC_FAIL("malloc");
+
+	++ d->visit;
+	build_deps_mark_failed(d, build_deps_get(d, path));
+}
+
+void build_deps_update(build_deps_t *d, build_cache_t *c) {
+	for (size_t i = 0; i < d->count; ++ i) {
+		/* Sources are not marked here, only headers. A header that a failed source includes
+		   keeps its old time, otherwise the source would not be rebuilt after it is fixed */
+		if (d->buf[i].changed && !d->buf[i].failed)
+			build_cache_set(c, d->buf[i].path, d->buf[i].mtime);
+	}
+}
+
+static bool build_clean_files(const char *path, bool all) {
+	bool found = false;
+	int  status;
+	FOREACH_IN_DIR(path, dir, ent, {
+		if (ent.attr & FS_DIR)
+			continue;
+
+		if (!all && strcmp(fs_ext(ent.name), "o") != 0 && strcmp(fs_ext(ent.name), "gcda") != 0)
+			continue;
+
+		char *file = FS_JOIN_PATH(dir.path, ent.name);
+		if (file == NULL)
+			FATAL_FUNC_FAIL("malloc");
+
+		if (fs_remove_file(file) == 0)
+			found = true;
+
+		free(file);
+	}, status);
+
+	if (status != 0)
+		LOG_FATAL("Failed to open directory '%s'", path);
+
+	return found;
+}
+
+bool build_clean_variant(const char *bin, const char *variant) {
+	char *obj_dir = variant == NULL? FS_JOIN_PATH(bin) : FS_JOIN_PATH(bin, variant);
+	if (obj_dir == NULL)
+		FATAL_FUNC_FAIL("malloc");
+
+	bool found = false;
+	if (fs_exists(obj_dir)) {
+		found = build_clean_files(obj_dir, false);
+
+		/* The PGO directory is only ever written by build_app, so everything inside of it goes */
+		char *gen_dir = FS_JOIN_PATH(obj_dir, BUILD_PGO_DIR);
+		if (gen_dir == NULL)
+			FATAL_FUNC_FAIL("malloc");
+
+		if (fs_exists(gen_dir)) {
+			build_clean_files(gen_dir, true);
+			if (fs_remove_dir(gen_dir) == 0)
+				found = true;
+		}
+
+		free(gen_dir);
+	}
+
+	if (variant == NULL) {
+		if (build_cache_delete() == 0)
+			found = true;
+	} else if (fs_exists(obj_dir)) {
+		char *cache_path = FS_JOIN_PATH(obj_dir, BUILD_CACHE_PATH);
+		if (cache_path == NULL)
+			FATAL_FUNC_FAIL("malloc");
+
+		if (fs_remove_file(cache_path) == 0)
+			found = true;
+
+		free(cache_path);
+
+		/* Fails if the variant directory also holds other files, like the output binary */
+		if (fs_remove_dir(obj_dir) == 0)
+			found = true;
+	}
+
+	free(obj_dir);
+	return found;
+}
+
+void build_clean(const char *path) {
+	if (!fs_exists(path))
+		LOG_FATAL("Failed to open directory '%s'", path);
+
+	if (!build_clean_variant(path, NULL))
+		LOG_INFO("Nothing to clean");
+	else
+		LOG_INFO("Cleaned '%s'", path);
+}
+
+/* Macros that have to be defined for this function */
+#ifndef CARGS
+#	define CARGS
+#endif
+
+#ifndef CLIBS
+#	define CLIBS
+#endif
+
+static int build_cmd_join(const char *compiler, const char **a, size_t a_count,
+                          const char **b, size_t b_count, const char **c, size_t c_count) {
+	const char **argv = (const char**)malloc((a_count + b_count + c_count + 2) * sizeof(*argv));
+	if (argv == NULL)
+		FATAL_FUNC_FAIL("malloc");
+
+	argv[0] = compiler;
+	size_t pos = 1;
+
+	for (size_t i = 0; i < a_count; ++ i, ++ pos)
+		argv[pos] = a[i];
+
+	for (size_t i = 0; i < b_count; ++ i, ++ pos)
+		argv[pos] = b[i];
+
+	for (size_t i = 0; i < c_count; ++ i, ++ pos)
+		argv[pos] = c[i];
+
+	argv[pos] = NULL;
+
+	int code = cmd(argv);
+	free(argv);
+	return code;
+}
+
+typedef struct {
+	build_cache_t *c;
+	build_deps_t  *deps;
+	char          *src;
+	int64_t        mtime;
+	bool          *failed;
+} build_file_job_t;
+
+static void build_file_done(void *data, bool ok) {
+	build_file_job_t *job = (build_file_job_t*)data;
+
+	/* Only mark the source as up to date when it was compiled successfully */
+	if (ok)
+		build_cache_set(job->c, job->src, job->mtime);
+	else {
+		build_deps_failed(job->deps, job->src);
+		*job->failed = true;
+	}
+
+	free(job->src);
+	free(job);
+}
+
+static char *build_file(const char *cc, build_cache_t *c, build_deps_t *deps,
+                        const char *out_dir, const char *src_dir, const char *src_name,
+                        const char **flags, size_t flags_count,
+                        bool force_rebuild, bool *rebuilt, bool *failed) {
+	/* Get the object file and source file paths */
+	char *out_name = fs_replace_ext(src_name, "o");
+	if (out_name == NULL)
+		FATAL_FUNC_FAIL("malloc");
+
+	char *out = FS_JOIN_PATH(out_dir, out_name);
+	char *src = FS_JOIN_PATH(src_dir, src_name);
+	if (out_name == NULL || out == NULL || src == NULL)
+		FATAL_FUNC_FAIL("malloc");
+
+	free(out_name);
+
+	/* Compile if the file needs to be compiled */
+	int64_t m_cached = build_cache_get(c, src);
+	int64_t m_now;
+	if (fs_time(src, &m_now, NULL) != 0)
+		LOG_FATAL("Could not get last modified time of '%s'", src);
+
+	/* The includes are always checked, even when the source changed, so that the scanner knows
+	   every header of the source for build_deps_update and build_deps_failed */
+	bool deps_changed = build_deps_changed(deps, c, src);
+	if (m_cached != m_now || force_rebuild || deps_changed || !fs_exists(out)) {
+		build_file_job_t *job = (build_file_job_t*)malloc(sizeof(*job));
+		if (job == NULL)
+			FATAL_FUNC_FAIL("malloc");
+
+		job->c      = c;
+		job->deps   = deps;
+		job->src    = src;
+		job->mtime  = m_now;
+		job->failed = failed;
+
+		const char *args[] = {"-c", src, "-o", out, CARGS};
+
+		size_t       argc = 1 + ARRAY_SIZE(args) + flags_count;
+		const char **argv = (const char**)malloc((argc + 1) * sizeof(*argv));
+		if (argv == NULL)
+			FATAL_FUNC_FAIL("malloc");
+
+		argv[0] = cc;
+		for (size_t i = 0; i < ARRAY_SIZE(args); ++ i)
+			argv[1 + i] = args[i];
+
+		for (size_t i = 0; i < flags_count; ++ i)
+			argv[1 + ARRAY_SIZE(args) + i] = flags[i];
+
+		argv[argc] = NULL;
+
+		/* The job owns 'src' now */
+		build_job_start(argv, build_file_done, job);
+		free(argv);
+
+		*rebuilt = true;
+	} else
+		free(src);
+
+	return out;
+}
+
+static bool build_app_stage(const char *compiler, build_app_config_t *config, build_cache_t *c,
+                            const char *obj_dir, const char *out,
+                            const char **stage_flags, size_t stage_flags_count, bool rebuild_all) {
+	if (!fs_exists(obj_dir))
+		fs_create_dir(obj_dir);
+
+	/* The config flags come first, so that the stage flags can override them */
+	size_t       flags_count = config->flags_count + stage_flags_count;
+	const char **flags       = (const char**)malloc((flags_count + 1) * sizeof(*flags));
+	if (flags == NULL)
+		FATAL_FUNC_FAIL("malloc");
+
+	for (size_t i = 0; i < config->flags_count; ++ i)
+		flags[i] = config->flags[i];
+
+	for (size_t i = 0; i < stage_flags_count; ++ i)
+		flags[config->flags_count + i] = stage_flags[i];
+
+	char  *o_files[128];
+	size_t o_files_count = 0;
+	bool   rebuilt       = false, failed = false;
+
+	build_deps_t deps;
+	build_deps_init(&deps, config->include_dirs, config->include_dirs_count);
+
+	/* Compile files in all source directories */
+	for (size_t i = 0; i < config->srcs_count; ++ i) {
+		int status;
 
 		/* Rebuild source files */
 		FOREACH_IN_DIR(config->srcs[i], dir, ent, {
@@ -778,29 +1727,583 @@ void build_app(const char *compiler, build_app_config_t *config, build_cache_t *
 
 			assert(o_files_count < sizeof(o_files) / sizeof(o_files[0]));
 
-			char *out = build_file(compiler, c, config->bin, config->srcs[i],
-			                       ent.name, rebuild_all);
-			o_files[o_files_count ++] = out;
+			char *obj = build_file(compiler, c, &deps, obj_dir, config->srcs[i], ent.name,
+			                       flags, flags_count, rebuild_all, &rebuilt, &failed);
+			o_files[o_files_count ++] = obj;
 		}, status);
 
 		if (status != 0)
 			LOG_FATAL("Failed to open directory '%s'", config->srcs[i]);
 	}
 
-	if (o_files_count == 0)
+	build_job_wait_all();
+
+	/* Sources that failed to compile and their headers are not marked, so they are rebuilt next
+	   time */
+	build_deps_update(&deps, c);
+	build_deps_free(&deps);
+
+	bool ok = !failed;
+	if (!rebuilt && fs_exists(out))
 		LOG_INFO("Nothing to rebuild");
 	else {
 		if (build_cache_save(c) != 0)
 			LOG_FATAL("Failed to save build cache");
 
-		COMPILE(compiler, o_files, o_files_count, "-o", config->out, CARGS, CLIBS);
+		if (failed) {
+			/* Only reachable in the keep-going policy */
+			LOG_ERROR("Not linking '%s', because some of its objects failed to compile", out);
+		} else {
+			const char *args[] = {"-o", out, CARGS, CLIBS};
+			ok = build_cmd_join(compiler, (const char**)o_files, o_files_count,
+			                    flags, flags_count, args, ARRAY_SIZE(args)) == 0;
+		}
+	}
 
-		for (size_t i = 0; i < o_files_count; ++ i)
-			free(o_files[i]);
+	for (size_t i = 0; i < o_files_count; ++ i)
+		free(o_files[i]);
+
+	free(flags);
+	return ok;
+}
+
+static int build_pgo_train(const char **train, const char *app) {
+	size_t count = 0;
+	while (train[count] != NULL)
+		++ count;
+
+	const char **argv = (const char**)malloc((count + 1) * sizeof(*argv));
+	if (argv == NULL)
+		FATAL_FUNC_FAIL("malloc");
+
+	/* Substitute the instrumented binary path for the placeholder arguments */
+	for (size_t i = 0; i < count; ++ i)
+		argv[i] = strcmp(train[i], BUILD_PGO_APP) == 0? app : train[i];
+
+	argv[count] = NULL;
+
+	int code = cmd(argv);
+	free(argv);
+	return code;
+}
+
+static void build_pgo_remove_profiles(const char *path) {
+	int status;
+	FOREACH_IN_DIR(path, dir, ent, {
+		if (strcmp(fs_ext(ent.name), "gcda") != 0)
+			continue;
+
+		char *gcda = FS_JOIN_PATH(dir.path, ent.name);
+		if (gcda == NULL)
+			FATAL_FUNC_FAIL("malloc");
+
+		fs_remove_file(gcda);
+		free(gcda);
+	}, status);
+
+	if (status != 0)
+		LOG_FATAL("Failed to open directory '%s'", path);
+}
+
+static bool build_pgo_copy_profiles(build_cache_t *c, const char *from, const char *to,
+                                    bool force) {
+	bool changed = false;
+	int  status;
+	FOREACH_IN_DIR(from, dir, ent, {
+		if (strcmp(fs_ext(ent.name), "gcda") != 0)
+			continue;
+
+		char *src = FS_JOIN_PATH(from, ent.name);
+		char *dst = FS_JOIN_PATH(to,   ent.name);
+		if (src == NULL || dst == NULL)
+			FATAL_FUNC_FAIL("malloc");
+
+		/* Only copy profiles that changed since the last build, unless they were just retrained */
+		if (build_cache_update(c, src) || force || !fs_exists(dst)) {
+			if (fs_copy_file(src, dst) != 0)
+				LOG_FATAL("Failed to copy profile '%s' to '%s'", src, dst);
+
+			changed = true;
+		}
+
+		free(src);
+		free(dst);
+	}, status);
+
+	if (status != 0)
+		LOG_FATAL("Failed to open directory '%s'", from);
+
+	return changed;
+}
+
+static bool build_app_pgo(const char *compiler, build_app_config_t *config, build_cache_t *c,
+                          const char *obj_dir) {
+	bool ok = true, trained = false;
+
+	char *gen_dir = FS_JOIN_PATH(obj_dir, BUILD_PGO_DIR);
+	if (gen_dir == NULL)
+		FATAL_FUNC_FAIL("malloc");
+
+	char *gen_out   = FS_JOIN_PATH(gen_dir, fs_basename(config->out));
+	char *gen_cache = FS_JOIN_PATH(gen_dir, BUILD_CACHE_PATH);
+	if (gen_out == NULL || gen_cache == NULL)
+		FATAL_FUNC_FAIL("malloc");
+
+	if (!fs_exists(gen_dir))
+		fs_create_dir(gen_dir);
+
+	build_cache_t gen_c;
+	if (build_cache_load_from(&gen_c, gen_cache) != 0)
+		LOG_FATAL("Build cache '%s' is corrupted", gen_cache);
+
+	/* The instrumented binary is recorded in the cache with its last modified time once it
+	   has been trained, so an unchanged profile is never regenerated */
+	int64_t m_trained = build_cache_get(&gen_c, gen_out);
+	if (m_trained == -1 || config->pgo_retrain) {
+		LOG_CUSTOM("PGO", "Building instrumented '%s'", gen_out);
+
+		/* Retraining rebuilds the instrumented binary too, so that it matches the sources */
+		const char *gen_flags[] = {"-fprofile-generate"};
+		ok = build_app_stage(compiler, config, &gen_c, gen_dir, gen_out,
+		                     gen_flags, ARRAY_SIZE(gen_flags),
+		                     config->rebuild_all || config->pgo_retrain);
+
+		int64_t m_now;
+		if (!ok)
+			LOG_ERROR("Failed to build instrumented '%s'", gen_out);
+		else if (fs_time(gen_out, &m_now, NULL) != 0)
+			LOG_FATAL("Could not get last modified time of '%s'", gen_out);
+		else if (m_now != m_trained || config->pgo_retrain) {
+			LOG_CUSTOM("PGO", "Training '%s'", gen_out);
+
+			/* Profiles of a previous training would be merged into the new ones */
+			build_pgo_remove_profiles(gen_dir);
+			ok = build_pgo_train(config->pgo_train, gen_out) == 0;
+			if (ok) {
+				build_cache_set(&gen_c, gen_out, m_now);
+				trained = true;
+			}
+		} else
+			LOG_INFO("Profile of '%s' is up to date", gen_out);
+
+		if (build_cache_save(&gen_c) != 0)
+			LOG_FATAL("Failed to save build cache '%s'", gen_cache);
+	} else
+		LOG_CUSTOM("PGO", "Reusing the profile of '%s'", gen_out);
+
+	if (!ok) {
+		build_cache_free(&gen_c);
+		free(gen_cache);
+		free(gen_out);
+		free(gen_dir);
+		return false;
 	}
 
+	/* GCC looks for the profile of an object next to it, so the profiles are copied into the
+	   output directory. A changed profile means that every object has to be rebuilt */
+	bool rebuild_all = build_pgo_copy_profiles(c, gen_dir, obj_dir, trained) ||
+	                   config->rebuild_all;
+
+	/* Sources that changed since the training are built with a partially stale profile */
+	const char *use_flags[] = {
+		"-fprofile-use", "-Wno-missing-profile", "-Wno-error=coverage-mismatch",
+	};
+	ok = build_app_stage(compiler, config, c, obj_dir, config->out,
+	                     use_flags, ARRAY_SIZE(use_flags), rebuild_all);
+
+	build_cache_free(&gen_c);
+	free(gen_cache);
+	free(gen_out);
+	free(gen_dir);
+	return ok;
+}
+
+void build_app(const char *compiler, build_app_config_t *config, build_cache_t *c) {
+	if (!fs_exists(config->bin))
+		fs_create_dir(config->bin);
+
+	/* Each variant has its own object directory with its own build cache inside of it */
+	char *obj_dir    = NULL;
+	char *cache_path = NULL;
+	if (config->variant != NULL) {
+		obj_dir    = FS_JOIN_PATH(config->bin, config->variant);
+		cache_path = FS_JOIN_PATH(config->bin, config->variant, BUILD_CACHE_PATH);
+		if (obj_dir == NULL || cache_path == NULL)
+			FATAL_FUNC_FAIL("malloc");
+
+		if (!fs_exists(obj_dir))
+			fs_create_dir(obj_dir);
+	}
+
+	build_cache_t c_;
+	bool create_build_cache_struct = c == NULL;
+	if (create_build_cache_struct) {
+		if (build_cache_load_from(&c_, cache_path == NULL? BUILD_CACHE_PATH : cache_path) != 0)
+			LOG_FATAL("Build cache is corrupted");
+		c = &c_;
+	}
+
+	const char *dir = obj_dir == NULL? config->bin : obj_dir;
+	bool ok;
+	if (config->pgo_train != NULL)
+		ok = build_app_pgo(compiler, config, c, dir);
+	else
+		ok = build_app_stage(compiler, config, c, dir, config->out, NULL, 0, config->rebuild_all);
+
 	if (create_build_cache_struct)
 		build_cache_free(c);
+
+	free(cache_path);
+	free(obj_dir);
+
+	if (!ok) {
+		build_report();
+		LOG_FATAL("Failed to build '%s'", config->out);
+	}
+}
+
+#ifndef BUILD_PLATFORM_WINDOWS
+static void build_variant_terminate(int sig) {
+	UNUSED(sig);
+
+	/* Take the running jobs and the blocking command (like linking or PGO training) of the
+	   variant down with it. Only async-signal-safe calls here */
+	for (size_t i = 0; i < _build_running_count; ++ i)
+		kill(_build_running[i].proc.pid, SIGTERM);
+
+	if (_build_cmd_pid != 0)
+		kill((pid_t)_build_cmd_pid, SIGTERM);
+
+	_exit(EXIT_FAILURE);
+}
+#endif
+
+void build_apps(const char *compiler, build_app_config_t *configs, size_t count) {
+#ifdef BUILD_PLATFORM_WINDOWS
+	for (size_t i = 0; i < count; ++ i)
+		build_app(compiler, &configs[i], NULL);
+#else
+	pid_t *pids = (pid_t*)malloc(count * sizeof(*pids));
+	if (pids == NULL)
+		FATAL_FUNC_FAIL("malloc");
+
+	/* The variants do not share any files, so each one can be built in its own process */
+	for (size_t i = 0; i < count; ++ i) {
+		fflush(stdout);
+		fflush(stderr);
+
+		pids[i] = fork();
+		if (pids[i] == 0) {
+			signal(SIGTERM, build_variant_terminate);
+
+			build_app(compiler, &configs[i], NULL);
+			exit(EXIT_SUCCESS);
+		} else if (pids[i] == -1)
+			FATAL_FUNC_FAIL("fork");
+	}
+
+	size_t failed = 0, running = count;
+	bool   cancelled = false;
+	while (running > 0) {
+		/* Only the variants are waited for, so that the processes of cmd_async are left alone */
+		size_t i = 0;
+		int    code;
+		for (; i < count; ++ i) {
+			proc_t p;
+			p.pid = pids[i];
+			if (pids[i] != -1 && build_proc_poll(p, &code))
+				break;
+		}
+
+		if (i >= count) {
+			build_sleep_ms(1);
+			continue;
+		}
+
+		pids[i] = -1;
+		-- running;
+
+		if (code == 0)
+			continue;
+
+		const char *name = configs[i].variant == NULL? configs[i].out : configs[i].variant;
+		++ failed;
+
+		if (cancelled) {
+			LOG_WARN("Cancelled building variant '%s'", name);
+			continue;
+		}
+
+		LOG_ERROR("Failed to build variant '%s'", name);
+		if (_build_policy == BUILD_FAIL_FAST) {
+			cancelled = true;
+			for (size_t j = 0; j < count; ++ j) {
+				if (pids[j] != -1)
+					kill(pids[j], SIGTERM);
+			}
+		}
+	}
+
+	free(pids);
+
+	if (failed > 0)
+		LOG_FATAL("%zu out of %zu variants failed to build", failed, count);
+#endif
+}
+
+static double build_time_now(void) {
+#ifdef BUILD_PLATFORM_WINDOWS
+	LARGE_INTEGER freq, now;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&now);
+	return (double)now.QuadPart / (double)freq.QuadPart;
+#else
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (double)tv.tv_sec + (double)tv.tv_usec / 1000000.0;
+#endif
+}
+
+/* Start 'argv' with its stdout and stderr redirected into the file 'log' */
+static proc_t build_test_spawn(const char **argv, const char *log) {
+	proc_t p;
+
+	fflush(stdout);
+	fflush(stderr);
+
+#ifdef BUILD_PLATFORM_WINDOWS
+	SECURITY_ATTRIBUTES sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.nLength        = sizeof(sa);
+	sa.bInheritHandle = TRUE;
+
+	HANDLE out = CreateFileA(log, GENERIC_WRITE, FILE_SHARE_READ, &sa, CREATE_ALWAYS,
+	                         FILE_ATTRIBUTE_NORMAL, NULL);
+	if (out == INVALID_HANDLE_VALUE)
+		LOG_FATAL("Could not open test log '%s'", log);
+
+	STARTUPINFO si;
+	PROCESS_INFORMATION pi;
+
+	memset(&si, 0, sizeof(si));
+	memset(&pi, 0, sizeof(pi));
+	si.cb         = sizeof(si);
+	si.dwFlags    = STARTF_USESTDHANDLES;
+	si.hStdInput  = GetStdHandle(STD_INPUT_HANDLE);
+	si.hStdOutput = out;
+	si.hStdError  = out;
+
+	size_t len = 1;
+	for (const char **next = argv; *next != NULL; ++ next)
+		len += strlen(*next) + 3;
+
+	char *cmd_line = (char*)malloc(len);
+	if (cmd_line == NULL)
+		FATAL_FUNC_FAIL("malloc");
+
+	memset(cmd_line, 0, len);
+	for (const char **next = argv; *next != NULL; ++ next) {
+		if (next != argv)
+			strcat(cmd_line, " ");
+
+		strcat(cmd_line, "\"");
+		strcat(cmd_line, *next);
+		strcat(cmd_line, "\"");
+	}
+
+	if (!CreateProcessA(NULL, cmd_line, NULL, NULL, TRUE, 0, NULL, NULL, &si, &pi))
+		LOG_FATAL("Could not execute command '%s' %d", argv[0], GetLastError());
+
+	free(cmd_line);
+	CloseHandle(out);
+	CloseHandle(pi.hThread);
+
+	p.handle = pi.hProcess;
+#else
+	p.pid = fork();
+	if (p.pid == 0) {
+		int fd = open(log, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0)
+			_exit(127);
+
+		dup2(fd, STDOUT_FILENO);
+		dup2(fd, STDERR_FILENO);
+		close(fd);
+
+		execvp(argv[0], (char**)argv);
+		fprintf(stderr, "Could not execute command '%s'\n", argv[0]);
+		_exit(127);
+	} else if (p.pid == -1)
+		FATAL_FUNC_FAIL("fork");
+#endif
+
+	return p;
+}
+
+static void build_test_print_log(const char *log) {
+	FILE *f = fopen(log, "r");
+	if (f == NULL)
+		return;
+
+	int ch;
+	while ((ch = fgetc(f)) != EOF)
+		fputc(ch, stderr);
+
+	fclose(f);
+}
+
+static char *build_test_key(const char *name, const char *path) {
+	char *key = (char*)malloc(strlen(name) + strlen(path) + 2);
+	if (key == NULL)
+		FATAL_FUNC_FAIL("malloc");
+
+	strcpy(key, name);
+	strcat(key, ":");
+	strcat(key, path);
+	return key;
+}
+
+/* The paths are cached per test, so that a passing test does not hide a modified input from
+   the other tests that read it */
+static bool build_test_is_fresh(build_cache_t *c, build_test_t *t) {
+	for (size_t i = 0; i < t->inputs_count + 1; ++ i) {
+		const char *path = i == 0? t->argv[0] : t->inputs[i - 1];
+		char       *key  = build_test_key(t->name, path);
+
+		int64_t m_now;
+		bool fresh = fs_time(path, &m_now, NULL) == 0 && build_cache_get(c, key) == m_now;
+		free(key);
+
+		if (!fresh)
+			return false;
+	}
+
+	return true;
+}
+
+static void build_test_mark(build_cache_t *c, build_test_t *t, bool passed) {
+	for (size_t i = 0; i < t->inputs_count + 1; ++ i) {
+		const char *path = i == 0? t->argv[0] : t->inputs[i - 1];
+		char       *key  = build_test_key(t->name, path);
+
+		int64_t m_now = -1;
+		if (passed)
+			fs_time(path, &m_now, NULL);
+
+		build_cache_set(c, key, m_now);
+		free(key);
+	}
+}
+
+typedef struct {
+	proc_t  proc;
+	size_t  idx;
+	double  start;
+	char   *log;
+} build_test_run_t;
+
+size_t build_run_tests(build_test_t *tests, size_t count, const char *log_dir) {
+	if (!fs_exists(log_dir))
+		fs_create_dir(log_dir);
+
+	build_cache_t c;
+	if (build_cache_load_from(&c, BUILD_TEST_CACHE_PATH) != 0)
+		LOG_FATAL("Test cache is corrupted");
+
+	build_test_run_t running[BUILD_MAX_JOBS];
+	size_t running_count = 0, next = 0;
+	size_t passed = 0, skipped = 0, failed = 0;
+
+	double start = build_time_now();
+	while (next < count || running_count > 0) {
+		/* Start as many tests as there are free jobs */
+		while (next < count && running_count < _build_jobs) {
+			build_test_t *t = &tests[next ++];
+			if (build_test_is_fresh(&c, t)) {
+				LOG_CUSTOM("SKIP", "%s (unchanged since it passed)", t->name);
+				++ skipped;
+				continue;
+			}
+
+			char *log_name = (char*)malloc(strlen(t->name) + 5);
+			if (log_name == NULL)
+				FATAL_FUNC_FAIL("malloc");
+
+			strcpy(log_name, t->name);
+			strcat(log_name, ".log");
+
+			build_test_run_t *run = &running[running_count ++];
+			run->idx   = (size_t)(t - tests);
+			run->log   = FS_JOIN_PATH(log_dir, log_name);
+			if (run->log == NULL)
+				FATAL_FUNC_FAIL("malloc");
+
+			free(log_name);
+
+			run->start = build_time_now();
+			run->proc  = build_test_spawn(t->argv, run->log);
+		}
+
+		/* Collect the finished tests and kill the ones that ran out of time */
+		for (size_t i = 0; i < running_count;) {
+			build_test_run_t *run = &running[i];
+			build_test_t     *t   = &tests[run->idx];
+
+			double timeout  = t->timeout > 0? t->timeout : BUILD_TEST_TIMEOUT;
+			double duration = build_time_now() - run->start;
+
+			int  code;
+			bool timed_out = false;
+			if (!build_proc_poll(run->proc, &code)) {
+				if (duration < timeout) {
+					++ i;
+					continue;
+				}
+
+#ifdef BUILD_PLATFORM_WINDOWS
+				proc_kill(run->proc);
+#else
+				/* The test might be stuck ignoring SIGTERM */
+				kill(run->proc.pid, SIGKILL);
+#endif
+				code      = proc_wait(run->proc);
+				timed_out = true;
+			}
+
+			bool ok = !timed_out && code == t->exit_code;
+			build_test_mark(&c, t, ok);
+
+			if (ok) {
+				LOG_CUSTOM("PASS", "%s (%.3fs)", t->name, duration);
+				++ passed;
+			} else {
+				if (timed_out)
+					LOG_ERROR("Test '%s' timed out after %.3fs, output:", t->name, duration);
+				else
+					LOG_ERROR("Test '%s' exited with exitcode '%i' instead of '%i' (%.3fs), output:",
+					          t->name, code, t->exit_code, duration);
+
+				build_test_print_log(run->log);
+				build_record_failure(build_cmd_str(t->argv), code);
+				++ failed;
+			}
+
+			free(run->log);
+			*run = running[-- running_count];
+		}
+
+		if (running_count > 0)
+			build_sleep_ms(1);
+	}
+
+	if (build_cache_save(&c) != 0)
+		LOG_FATAL("Failed to save test cache");
+
+	build_cache_free(&c);
+
+	LOG_INFO("%zu passed, %zu skipped, %zu failed (%.3fs)",
+	         passed, skipped, failed, build_time_now() - start);
+	return failed;
 }
 
 #ifdef __cplusplus
@@ -17,11 +17,13 @@ extern "C" {
 #endif
 
 #include <assert.h> /* assert */
-#include <stdlib.h> /* malloc, realloc, free */
+#include <stdlib.h> /* size_t */
 #include <string.h> /* memset, strlen, strcpy */
 
+#include "alloc.h"
+
 #define CHOL_COMMON_VERSION_MAJOR 1
-#define CHOL_COMMON_VERSION_MINOR 3
+#define CHOL_COMMON_VERSION_MINOR 4
 #define CHOL_COMMON_VERSION_PATCH 2
 
 /*
@@ -31,6 +33,7 @@ extern "C" {
  * 1.1.2: Add ZERO_STRUCT
  * 1.2.2: Add strcpy_to_heap
  * 1.3.2: Add collision_free_hash
+ * 1.4.2: Add common_set_allocator
  */
 
 #define UNREACHABLE(MSG)      assert(0 && "Unreachable: " MSG)
@@ -161,6 +164,15 @@ void *salloc(size_t memb_size, size_t count);
 int   srealloc(void **ptr, size_t memb_size, size_t count);
 int   sfree(void **ptr);
 
+void common_set_allocator(const allocator_t *a);
+
+/*
+ * void common_set_allocator(const allocator_t *a)
+ *     Makes salloc, srealloc, sfree and strcpy_to_heap allocate with 'a' (see alloc.h). NULL
+ *     restores the default libc allocator. 'a' has to stay valid while it is set, and memory has
+ *     to be freed with the allocator it was allocated with.
+ */
+
 #ifdef __cplusplus
 }
 #endif
@@ -186,8 +198,14 @@ unsigned collision_free_hash(const char *key) {
 	return hash;
 }
 
+static const allocator_t *common_allocator = NULL;
+
+void common_set_allocator(const allocator_t *a) {
+	common_allocator = a;
+}
+
 char *strcpy_to_heap(const char *str) {
-	char *copy = (char*)malloc(strlen(str) + 1);
+	char *copy = (char*)allocator_alloc(common_allocator, strlen(str) + 1);
 	if (copy == NULL)
 		return NULL;
 
@@ -196,14 +214,14 @@ char *strcpy_to_heap(const char *str) {
 }
 
 void *salloc(size_t memb_size, size_t count) {
-	return malloc(memb_size * count);
+	return allocator_alloc(common_allocator, memb_size * count);
 }
 
 int srealloc(void **ptr, size_t memb_size, size_t count) {
 	if (*ptr == NULL)
 		return -1;
 
-	void *new_ = realloc(*ptr, memb_size * count);
+	void *new_ = allocator_realloc(common_allocator, *ptr, memb_size * count);
 	if (new_ == NULL) {
 		sfree(ptr);
 		return -1;
@@ -217,7 +235,7 @@ int sfree(void **ptr) {
 	if (*ptr == NULL)
 		return -1;
 
-	free(*ptr);
+	allocator_free(common_allocator, *ptr);
 	*ptr = NULL;
 
 	return 0;
@@ -34,24 +34,52 @@ int main(void) {
 extern "C" {
 #endif
 
-#include <stdlib.h> /* size_t, malloc, realloc, free */
-#include <string.h> /* memcpy */
+#include <stdlib.h>  /* size_t */
+#include <string.h>  /* memcpy, memset */
+#include <stdint.h>  /* SIZE_MAX, uintptr_t */
+#include <stdbool.h> /* bool, true, false */
+#include <assert.h>  /* assert */
+
+#include "alloc.h"
 
 #define CHOL_DARRAY_VERSION_MAJOR 1
-#define CHOL_DARRAY_VERSION_MINOR 0
-#define CHOL_DARRAY_VERSION_PATCH 0
+#define CHOL_DARRAY_VERSION_MINOR 8
+#define CHOL_DARRAY_VERSION_PATCH 2
 
 /*
  * 1.0.0: Dynamic array structure, appending, indexing, foreach...
+ * 1.1.1: Fix darray_add reallocating 'size' bytes instead of 'size' elements, make darray_add
+ *        keep the buffer on failure, add darray_init_cap, darray_reserve, darray_resize,
+ *        darray_shrink_to_fit and the growth factor macros
+ * 1.2.1: Add DARRAY_DEFINE for type-specialized dynamic arrays
+ * 1.3.1: Add darray_extend, darray_insert_range, darray_remove_range and darray_swap_remove
+ * 1.4.1: Add DARRAY_DEFINE_SMALL for dynamic arrays with inline storage
+ * 1.5.1: Add custom allocator support (darray_init_with, 'NAME'_init_with)
+ * 1.6.1: Add darray_sort, darray_bsearch, darray_lower_bound, darray_radix_sort and
+ *        DARRAY_DEFINE_SORT
+ * 1.7.1: Add FOREACH_IN_DARRAY_UNCHECKED and darray_parallel_for
+ * 1.7.2: Fix darray_extend and darray_insert_range reading freed memory when 'data' points into
+ *        the array
+ * 1.8.2: Add DARRAY_MIN_CHUNK, make darray_parallel_for not start threads for small arrays
  */
 
 #ifndef DARRAY_CHUNK_SIZE
 #	define DARRAY_CHUNK_SIZE 32
 #endif
 
+#ifndef DARRAY_GROWTH_NUM
+#	define DARRAY_GROWTH_NUM 2
+#endif
+
+#ifndef DARRAY_GROWTH_DEN
+#	define DARRAY_GROWTH_DEN 1
+#endif
+
 typedef struct {
 	void  *buf;
 	size_t count, size, elem_size;
+
+	const allocator_t *allocator;
 } darray_t;
 
 /*
@@ -59,6 +87,11 @@ typedef struct {
  *     The size of a chunk allocated by darray in elements. If not defined before including,
  *     the default is 32.
  *
+ * DARRAY_GROWTH_NUM, DARRAY_GROWTH_DEN
+ *     The growth factor of darray is DARRAY_GROWTH_NUM / DARRAY_GROWTH_DEN. When a full darray
+ *     grows, its size is multiplied by the growth factor. If not defined before including, the
+ *     default is 2 / 1. The growth factor has to be greater than 1.
+ *
  *     darray_t
  *         Dynamic array structure
  *
@@ -70,10 +103,13 @@ typedef struct {
  *             Allocated size of the buffer (in elements)
  *         size_t elem_size
  *             Size of a single element in bytes
+ *         const allocator_t *allocator
+ *             The allocator of the buffer, NULL for libc (see alloc.h)
  */
 
-#define DARRAY_INIT(D, TYPE) darray_init(D, sizeof(TYPE))
-#define DARRAY_FREE(D)       darray_free(D)
+#define DARRAY_INIT(D, TYPE)          darray_init(D, sizeof(TYPE))
+#define DARRAY_INIT_CAP(D, TYPE, CAP) darray_init_cap(D, sizeof(TYPE), CAP)
+#define DARRAY_FREE(D)                darray_free(D)
 
 #define DARRAY_ADD(D, DATA_PTR)  darray_add(D, (void*)DATA_PTR)
 #define DARRAY_AT( D, IDX, TYPE) (TYPE*)darray_at(D, IDX)
@@ -92,10 +128,21 @@ typedef struct {
 		} \
 	} while (0)
 
+#define FOREACH_IN_DARRAY_UNCHECKED(D, TYPE, VAR, BODY) \
+	do { \
+		TYPE *_end = (TYPE*)(D)->buf + (D)->count; \
+		for (TYPE *VAR = (TYPE*)(D)->buf; VAR != _end; ++ VAR) { \
+			BODY \
+		} \
+	} while (0)
+
 /*
  * DARRAY_INIT(D, TYPE)
  *     Initializes 'D' for the type 'TYPE'. Returns 0 on success.
  *
+ * DARRAY_INIT_CAP(D, TYPE, CAP)
+ *     Initializes 'D' for the type 'TYPE' with space for 'CAP' elements. Returns 0 on success.
+ *
  * DARRAY_FREE(D)
  *     Frees 'D'.
  *
@@ -112,34 +159,631 @@ typedef struct {
  * FOREACH_IN_DARRAY(D, TYPE, VAR, BODY)
  *     Loops through each element in 'D'. 'VAR' is the name of the element pointer variable, which
  *     is of type pointer to 'TYPE' and 'BODY' is the code to run on each iteration.
+ *
+ * FOREACH_IN_DARRAY_UNCHECKED(D, TYPE, VAR, BODY)
+ *     Same as FOREACH_IN_DARRAY, but walks the buffer with a pointer instead of calling darray_at
+ *     on each step, so the loop has no bounds checks and can be vectorized. 'TYPE' has to match
+ *     the element size of 'D', and 'BODY' must not add or remove elements.
  */
 
-int  darray_init(darray_t *d, size_t elem_size);
-void darray_free(darray_t *d);
+int  darray_init(     darray_t *d, size_t elem_size);
+int  darray_init_cap( darray_t *d, size_t elem_size, size_t cap);
+int  darray_init_with(darray_t *d, size_t elem_size, size_t cap, const allocator_t *a);
+void darray_free(     darray_t *d);
 
 int   darray_add(darray_t *d, void  *data);
 void *darray_at( darray_t *d, size_t idx);
 
+int darray_reserve(      darray_t *d, size_t size);
+int darray_resize(       darray_t *d, size_t count);
+int darray_shrink_to_fit(darray_t *d);
+
+int darray_extend(      darray_t *d, const void *data, size_t n);
+int darray_insert_range(darray_t *d, size_t idx, const void *data, size_t n);
+int darray_remove_range(darray_t *d, size_t idx, size_t n);
+int darray_swap_remove( darray_t *d, size_t idx);
+
+typedef int (*darray_cmp_t)(const void*, const void*);
+
+typedef enum {
+	DARRAY_KEY_UINT = 0,
+	DARRAY_KEY_INT,
+	DARRAY_KEY_FLOAT,
+} darray_key_t;
+
+void   darray_sort(       darray_t *d, darray_cmp_t cmp);
+void  *darray_bsearch(    darray_t *d, const void *key, darray_cmp_t cmp);
+size_t darray_lower_bound(darray_t *d, const void *key, darray_cmp_t cmp);
+int    darray_radix_sort( darray_t *d, darray_key_t key);
+
+#ifdef DARRAY_PARALLEL
+#	ifndef DARRAY_CACHE_LINE
+#		define DARRAY_CACHE_LINE 64
+#	endif
+
+#	ifndef DARRAY_MAX_JOBS
+#		define DARRAY_MAX_JOBS 64
+#	endif
+
+#	ifndef DARRAY_MIN_CHUNK
+#		define DARRAY_MIN_CHUNK 1024
+#	endif
+
+typedef void (*darray_for_t)(void *elems, size_t count, void *ctx);
+
+void darray_parallel_for(darray_t *d, size_t jobs, darray_for_t fn, void *ctx);
+#endif
+
+/*
+ * The functions that return int return 0 on success. On failure (allocation fail or a size that
+ * would overflow), -1 is returned and 'd' is left unchanged.
+ *
+ * int darray_init_with(darray_t *d, size_t elem_size, size_t cap, const allocator_t *a)
+ *     Same as darray_init_cap, but all allocations of 'd' go through the allocator 'a' (NULL for
+ *     libc). 'a' has to outlive 'd'.
+ *
+ * int darray_reserve(darray_t *d, size_t size)
+ *     Makes sure 'd' has space for at least 'size' elements with a single allocation, so that
+ *     appending up to 'size' elements does not reallocate.
+ *
+ * int darray_resize(darray_t *d, size_t count)
+ *     Sets the count of elements in 'd' to 'count'. New elements are zero initialized.
+ *
+ * int darray_shrink_to_fit(darray_t *d)
+ *     Reallocates the buffer of 'd' to fit exactly its elements.
+ *
+ * The bulk functions below grow 'd' at most once and move the elements with a single memcpy or
+ * memmove, so prefer them over calling darray_add in a loop. On failure (including an index out
+ * of range), -1 is returned and 'd' is left unchanged.
+ *
+ * int darray_extend(darray_t *d, const void *data, size_t n)
+ *     Appends 'n' elements from 'data' to 'd'.
+ *
+ * int darray_insert_range(darray_t *d, size_t idx, const void *data, size_t n)
+ *     Inserts 'n' elements from 'data' into 'd' before 'idx'. 'idx' may be equal to the count of
+ *     elements, in which case it behaves like darray_extend.
+ *
+ *     For both functions, 'data' may point to elements of 'd' itself, for example to duplicate a
+ *     part of the array.
+ *
+ * int darray_remove_range(darray_t *d, size_t idx, size_t n)
+ *     Removes 'n' elements from 'd' starting at 'idx', keeping the order of the remaining
+ *     elements.
+ *
+ * int darray_swap_remove(darray_t *d, size_t idx)
+ *     Removes the element at 'idx' from 'd' by moving the last element into its place. Does not
+ *     keep the order, but runs in constant time.
+ *
+ * darray_cmp_t
+ *     Comparator type, same as the one taken by qsort.
+ *
+ * darray_key_t
+ *     Key type of the elements for darray_radix_sort.
+ *
+ *     DARRAY_KEY_UINT
+ *         Unsigned integers
+ *     DARRAY_KEY_INT
+ *         Signed (two's complement) integers
+ *     DARRAY_KEY_FLOAT
+ *         IEEE 754 floats (float or double). NaNs with the sign bit set sort first and the
+ *         others last.
+ *
+ * void darray_sort(darray_t *d, darray_cmp_t cmp)
+ *     Sorts the elements of 'd' in place with qsort. To inline the comparator, use
+ *     DARRAY_DEFINE_SORT or darray_radix_sort instead.
+ *
+ * void *darray_bsearch(darray_t *d, const void *key, darray_cmp_t cmp)
+ *     Returns a pointer to an element of the sorted 'd' equal to 'key', or NULL if there is none.
+ *
+ * size_t darray_lower_bound(darray_t *d, const void *key, darray_cmp_t cmp)
+ *     Returns the index of the first element of the sorted 'd' that is not less than 'key', or
+ *     the count of elements if there is none.
+ *
+ * int darray_radix_sort(darray_t *d, darray_key_t key)
+ *     Sorts the elements of 'd', which are numbers of type 'key', with an LSD radix sort. The
+ *     elements have to be 1, 2, 4 or 8 bytes big (4 or 8 for floats). The sort is stable, runs in
+ *     linear time and skips the passes over bytes that are the same in all the elements. It
+ *     needs a temporary buffer of the same size as 'd', so it returns -1 if that allocation
+ *     fails or the element size is not supported, 0 on success.
+ *
+ * The parallel functions are only available if DARRAY_PARALLEL is defined before including, as
+ * they need threads (pthreads on Unix/Linux, link with -pthread).
+ *
+ * DARRAY_CACHE_LINE
+ *     The cache line size in bytes. If not defined before including, the default is 64.
+ *
+ * DARRAY_MAX_JOBS
+ *     The maximum amount of threads darray_parallel_for runs. If not defined before including,
+ *     the default is 64.
+ *
+ * DARRAY_MIN_CHUNK
+ *     The minimum count of elements per thread of darray_parallel_for. If not defined before
+ *     including, the default is 1024. Should be raised for cheap bodies and lowered for expensive
+ *     ones.
+ *
+ * darray_for_t
+ *     Parallel-for body type. Receives a pointer to the first element of a chunk, the count of
+ *     elements in the chunk and the user context.
+ *
+ * void darray_parallel_for(darray_t *d, size_t jobs, darray_for_t fn, void *ctx)
+ *     Splits the elements of 'd' into chunks and calls 'fn' on each of them from 'jobs' threads
+ *     (the calling thread included), passing 'ctx' along. If 'jobs' is 0, the count of CPUs is
+ *     used. Returns after all the chunks are processed. If a thread cannot be started, its chunk
+ *     runs on the calling thread.
+ *
+ *     The threads are created and joined on each call, which costs far more than a short loop, so
+ *     fewer jobs are used to give each one at least DARRAY_MIN_CHUNK elements (and small arrays
+ *     run on the calling thread only). The chunk boundaries are rounded up to the next element
+ *     that starts on a DARRAY_CACHE_LINE boundary. Only if 'elem_size' divides DARRAY_CACHE_LINE
+ *     and the buffer is aligned to 'elem_size' do the chunks end exactly on a cache line, so that
+ *     two threads writing their own elements never share one. Otherwise the element before each
+ *     boundary straddles a cache line with the next chunk, which is still correct, only slower.
+ */
+
+#define DARRAY_DEFINE(NAME, TYPE) \
+	typedef struct { \
+		TYPE  *buf; \
+		size_t count, size; \
+		\
+		const allocator_t *allocator; \
+	} NAME##_t; \
+	\
+	static inline void NAME##_init_with(NAME##_t *d, const allocator_t *a) { \
+		d->buf       = NULL; \
+		d->count     = 0; \
+		d->size      = 0; \
+		d->allocator = a; \
+	} \
+	\
+	static inline void NAME##_init(NAME##_t *d) { \
+		NAME##_init_with(d, NULL); \
+	} \
+	\
+	static inline void NAME##_free(NAME##_t *d) { \
+		allocator_free(d->allocator, d->buf); \
+		NAME##_init_with(d, d->allocator); \
+	} \
+	\
+	static inline int NAME##_reserve(NAME##_t *d, size_t size) { \
+		if (size <= d->size) \
+			return 0; \
+		if (size > SIZE_MAX / sizeof(TYPE)) \
+			return -1; \
+		\
+		TYPE *tmp = (TYPE*)allocator_realloc(d->allocator, d->buf, size * sizeof(TYPE)); \
+		if (tmp == NULL) \
+			return -1; \
+		\
+		d->buf  = tmp; \
+		d->size = size; \
+		return 0; \
+	} \
+	\
+	static inline int NAME##_grow(NAME##_t *d) { \
+		size_t size = d->size > SIZE_MAX / DARRAY_GROWTH_NUM? \
+		              SIZE_MAX / sizeof(TYPE) : d->size * DARRAY_GROWTH_NUM / DARRAY_GROWTH_DEN; \
+		if (size < DARRAY_CHUNK_SIZE) \
+			size = DARRAY_CHUNK_SIZE; \
+		if (size <= d->size) \
+			return -1; \
+		\
+		return NAME##_reserve(d, size); \
+	} \
+	\
+	static inline int NAME##_push(NAME##_t *d, TYPE value) { \
+		if (d->count >= d->size) { \
+			if (NAME##_grow(d) != 0) \
+				return -1; \
+		} \
+		\
+		d->buf[d->count ++] = value; \
+		return 0; \
+	} \
+	\
+	static inline TYPE NAME##_pop(NAME##_t *d) { \
+		assert(d->count > 0); \
+		return d->buf[-- d->count]; \
+	} \
+	\
+	static inline TYPE *NAME##_at(NAME##_t *d, size_t idx) { \
+		assert(idx < d->count); \
+		return &d->buf[idx]; \
+	} \
+	\
+	static inline TYPE *NAME##_data(NAME##_t *d) { \
+		return d->buf; \
+	}
+
+/*
+ * DARRAY_DEFINE(NAME, TYPE)
+ *     Defines a dynamic array type 'NAME'_t specialized for the element type 'TYPE', along with
+ *     its functions. Unlike darray_t, the elements are copied with plain assignments and indexed
+ *     through a 'TYPE' pointer, so the compiler can keep them in registers and vectorize loops
+ *     over them. The growth follows the same macros as darray_t. Example:
+ *         | DARRAY_DEFINE(ints, int)
+ *         |
+ *         | ints_t nums;
+ *         | ints_init(&nums);
+ *         | if (ints_push(&nums, 5) != 0)
+ *         |     FATAL_FUNC_FAIL("ints_push");
+ *         | printf("%i\n", *ints_at(&nums, 0));
+ *         | ints_free(&nums);
+ *
+ *     'NAME'_t
+ *         TYPE *buf
+ *             The raw buffer
+ *         size_t count
+ *             Count of elements in the buffer
+ *         size_t size
+ *             Allocated size of the buffer (in elements)
+ *         const allocator_t *allocator
+ *             The allocator of the buffer, NULL for libc
+ *
+ *     void 'NAME'_init('NAME'_t *d)
+ *         Initializes 'd' as empty. Does not allocate.
+ *
+ *     void 'NAME'_init_with('NAME'_t *d, const allocator_t *a)
+ *         Same as 'NAME'_init, but 'd' allocates with 'a'.
+ *
+ *     void 'NAME'_free('NAME'_t *d)
+ *         Frees 'd'.
+ *
+ *     int 'NAME'_reserve('NAME'_t *d, size_t size)
+ *         Same as darray_reserve.
+ *
+ *     int 'NAME'_push('NAME'_t *d, TYPE value)
+ *         Appends 'value' to 'd'. Returns 0 on success.
+ *
+ *     TYPE 'NAME'_pop('NAME'_t *d)
+ *         Removes the last element of 'd' and returns it. 'd' must not be empty.
+ *
+ *     TYPE *'NAME'_at('NAME'_t *d, size_t idx)
+ *         Returns a pointer to the element of 'd' at 'idx'. The index is only checked with
+ *         assert.
+ *
+ *     TYPE *'NAME'_data('NAME'_t *d)
+ *         Returns the raw buffer of 'd'.
+ */
+
+#define DARRAY_DEFINE_SMALL(NAME, TYPE, N) \
+	typedef struct { \
+		TYPE  *heap; \
+		size_t count, size; \
+		TYPE   small[N]; \
+		\
+		const allocator_t *allocator; \
+	} NAME##_t; \
+	\
+	static inline void NAME##_init_with(NAME##_t *d, const allocator_t *a) { \
+		d->heap      = NULL; \
+		d->count     = 0; \
+		d->size      = N; \
+		d->allocator = a; \
+	} \
+	\
+	static inline void NAME##_init(NAME##_t *d) { \
+		NAME##_init_with(d, NULL); \
+	} \
+	\
+	static inline void NAME##_free(NAME##_t *d) { \
+		allocator_free(d->allocator, d->heap); \
+		NAME##_init_with(d, d->allocator); \
+	} \
+	\
+	static inline TYPE *NAME##_data(NAME##_t *d) { \
+		return d->heap == NULL? d->small : d->heap; \
+	} \
+	\
+	static inline bool NAME##_is_small(NAME##_t *d) { \
+		return d->heap == NULL; \
+	} \
+	\
+	static inline int NAME##_reserve(NAME##_t *d, size_t size) { \
+		if (size <= d->size) \
+			return 0; \
+		if (size > SIZE_MAX / sizeof(TYPE)) \
+			return -1; \
+		\
+		TYPE *tmp; \
+		if (d->heap == NULL) { \
+			tmp = (TYPE*)allocator_alloc(d->allocator, size * sizeof(TYPE)); \
+			if (tmp == NULL) \
+				return -1; \
+			\
+			memcpy(tmp, d->small, d->count * sizeof(TYPE)); \
+		} else { \
+			tmp = (TYPE*)allocator_realloc(d->allocator, d->heap, size * sizeof(TYPE)); \
+			if (tmp == NULL) \
+				return -1; \
+		} \
+		\
+		d->heap = tmp; \
+		d->size = size; \
+		return 0; \
+	} \
+	\
+	static inline int NAME##_grow(NAME##_t *d) { \
+		size_t size = d->size > SIZE_MAX / DARRAY_GROWTH_NUM? \
+		              SIZE_MAX / sizeof(TYPE) : d->size * DARRAY_GROWTH_NUM / DARRAY_GROWTH_DEN; \
+		if (size <= d->size) \
+			size = d->size + 1; \
+		\
+		return NAME##_reserve(d, size); \
+	} \
+	\
+	static inline int NAME##_push(NAME##_t *d, TYPE value) { \
+		if (d->count >= d->size) { \
+			if (NAME##_grow(d) != 0) \
+				return -1; \
+		} \
+		\
+		NAME##_data(d)[d->count ++] = value; \
+		return 0; \
+	} \
+	\
+	static inline TYPE NAME##_pop(NAME##_t *d) { \
+		assert(d->count > 0); \
+		return NAME##_data(d)[-- d->count]; \
+	} \
+	\
+	static inline TYPE *NAME##_at(NAME##_t *d, size_t idx) { \
+		assert(idx < d->count); \
+		return &NAME##_data(d)[idx]; \
+	}
+
+/*
+ * DARRAY_DEFINE_SMALL(NAME, TYPE, N)
+ *     Same as DARRAY_DEFINE, but the defined 'NAME'_t stores up to 'N' elements inline, inside
+ *     the structure itself. The elements spill to the heap only when more than 'N' are added, so
+ *     arrays that stay small never allocate, and a 'NAME'_t on the stack costs no malloc at all.
+ *     The structure holds no pointer into itself, so it can be copied while small. Example:
+ *         | DARRAY_DEFINE_SMALL(small_ints, int, 8)
+ *         |
+ *         | small_ints_t nums;
+ *         | small_ints_init(&nums);
+ *         | small_ints_push(&nums, 5); // does not allocate
+ *
+ *     'NAME'_t
+ *         TYPE *heap
+ *             The heap buffer, NULL while the elements are stored inline
+ *         size_t count
+ *             Count of elements
+ *         size_t size
+ *             Current capacity (in elements), 'N' while the elements are stored inline
+ *         TYPE small[N]
+ *             The inline buffer
+ *         const allocator_t *allocator
+ *             The allocator of the heap buffer, NULL for libc
+ *
+ *     bool 'NAME'_is_small('NAME'_t *d)
+ *         Returns true if the elements of 'd' are stored inline.
+ *
+ *     TYPE *'NAME'_data('NAME'_t *d)
+ *         Returns a pointer to the elements of 'd', either the inline or the heap buffer. The
+ *         pointer is invalidated when 'd' spills or grows.
+ *
+ *     The remaining functions behave the same as with DARRAY_DEFINE.
+ */
+
+#define DARRAY_DEFINE_SORT(NAME, TYPE, LESS) \
+	static inline void NAME##_sort_swap(TYPE *a, TYPE *b) { \
+		TYPE tmp = *a; \
+		*a = *b; \
+		*b = tmp; \
+	} \
+	\
+	static inline void NAME##_sort_insertion(TYPE *a, size_t n) { \
+		for (size_t i = 1; i < n; ++ i) { \
+			TYPE   x = a[i]; \
+			size_t j = i; \
+			for (; j > 0 && LESS(x, a[j - 1]); -- j) \
+				a[j] = a[j - 1]; \
+			\
+			a[j] = x; \
+		} \
+	} \
+	\
+	static inline void NAME##_sort_sift(TYPE *a, size_t root, size_t n) { \
+		TYPE x = a[root]; \
+		for (;;) { \
+			size_t child = root * 2 + 1; \
+			if (child >= n) \
+				break; \
+			\
+			if (child + 1 < n && LESS(a[child], a[child + 1])) \
+				++ child; \
+			\
+			if (!LESS(x, a[child])) \
+				break; \
+			\
+			a[root] = a[child]; \
+			root    = child; \
+		} \
+		\
+		a[root] = x; \
+	} \
+	\
+	static inline void NAME##_sort_heap(TYPE *a, size_t n) { \
+		for (size_t i = n / 2; i -- > 0;) \
+			NAME##_sort_sift(a, i, n); \
+		\
+		for (size_t i = n; i -- > 1;) { \
+			NAME##_sort_swap(&a[0], &a[i]); \
+			NAME##_sort_sift(a, 0, i); \
+		} \
+	} \
+	\
+	static inline void NAME##_sort_intro(TYPE *a, size_t n, size_t depth) { \
+		while (n > 16) { \
+			/* Quicksort went too deep, fall back to the guaranteed O(n log n) heapsort */ \
+			if (depth == 0) { \
+				NAME##_sort_heap(a, n); \
+				return; \
+			} \
+			-- depth; \
+			\
+			/* Median of three, so that a[0] and a[n - 1] stop the partition scans */ \
+			size_t mid = n / 2; \
+			if (LESS(a[mid],   a[0])) NAME##_sort_swap(&a[mid],   &a[0]); \
+			if (LESS(a[n - 1], a[0])) NAME##_sort_swap(&a[n - 1], &a[0]); \
+			if (LESS(a[n - 1], a[mid])) NAME##_sort_swap(&a[n - 1], &a[mid]); \
+			\
+			TYPE   pivot = a[mid]; \
+			size_t i = 0, j = n - 1; \
+			for (;;) { \
+				while (LESS(a[i], pivot)) \
+					++ i; \
+				while (LESS(pivot, a[j])) \
+					-- j; \
+				\
+				if (i >= j) \
+					break; \
+				\
+				NAME##_sort_swap(&a[i], &a[j]); \
+				++ i; \
+				-- j; \
+			} \
+			\
+			/* Recurse into the smaller part and loop on the bigger one to bound the stack */ \
+			if (i < n - i) { \
+				NAME##_sort_intro(a, i, depth); \
+				a += i; \
+				n -= i; \
+			} else { \
+				NAME##_sort_intro(a + i, n - i, depth); \
+				n = i; \
+			} \
+		} \
+		\
+		NAME##_sort_insertion(a, n); \
+	} \
+	\
+	static inline void NAME##_sort(TYPE *a, size_t n) { \
+		size_t depth = 0; \
+		for (size_t i = n; i > 1; i >>= 1) \
+			depth += 2; \
+		\
+		NAME##_sort_intro(a, n, depth); \
+	} \
+	\
+	static inline size_t NAME##_lower_bound(const TYPE *a, size_t n, TYPE key) { \
+		size_t lo = 0; \
+		while (n > 0) { \
+			size_t half = n / 2; \
+			if (LESS(a[lo + half], key)) { \
+				lo += half + 1; \
+				n  -= half + 1; \
+			} else \
+				n = half; \
+		} \
+		\
+		return lo; \
+	} \
+	\
+	static inline TYPE *NAME##_bsearch(TYPE *a, size_t n, TYPE key) { \
+		size_t idx = NAME##_lower_bound(a, n, key); \
+		return idx < n && !LESS(key, a[idx])? &a[idx] : NULL; \
+	}
+
+/*
+ * DARRAY_DEFINE_SORT(NAME, TYPE, LESS)
+ *     Defines sorting and searching functions prefixed with 'NAME' for arrays of 'TYPE'. 'LESS' is
+ *     a macro (or function) taking two values of 'TYPE' and returning true if the first is less
+ *     than the second. Because 'LESS' is expanded into the functions, it is inlined instead of
+ *     being called through a pointer like the qsort comparator. The functions work on raw
+ *     arrays, so they can be used with darray_t buffers and DARRAY_DEFINE types alike. Example:
+ *         | #define INT_LESS(A, B) ((A) < (B))
+ *         | DARRAY_DEFINE_SORT(ints, int, INT_LESS)
+ *         |
+ *         | ints_sort(nums.buf, nums.count);
+ *         | size_t idx = ints_lower_bound(nums.buf, nums.count, 5);
+ *
+ *     void 'NAME'_sort(TYPE *a, size_t n)
+ *         Sorts 'n' elements of 'a' with an introsort (quicksort with a median of three pivot,
+ *         falling back to heapsort when it recurses too deep and to insertion sort for small
+ *         ranges). The sort is not stable.
+ *
+ *     size_t 'NAME'_lower_bound(const TYPE *a, size_t n, TYPE key)
+ *         Returns the index of the first element of the sorted 'a' that is not less than 'key',
+ *         or 'n' if there is none.
+ *
+ *     TYPE *'NAME'_bsearch(TYPE *a, size_t n, TYPE key)
+ *         Returns a pointer to an element of the sorted 'a' equal to 'key', or NULL if there is
+ *         none.
+ */
+
 #ifdef __cplusplus
 }
 #endif
 #endif
 
 #ifdef CHOL_DARRAY_IMPLEMENTATION
+#ifdef DARRAY_PARALLEL
+#	include "sys.h"
+
+#	ifndef WIN32
+#		include <pthread.h> /* pthread_t, pthread_create, pthread_join */
+#	endif
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* Returns true if 'a * b' would overflow */
+static bool darray_mul_overflows(size_t a, size_t b) {
+	return b != 0 && a > SIZE_MAX / b;
+}
+
+static int darray_realloc(darray_t *d, size_t size) {
+	if (darray_mul_overflows(size, d->elem_size))
+		return -1;
+
+	void *tmp = allocator_realloc(d->allocator, d->buf, size * d->elem_size);
+	if (tmp == NULL)
+		return -1;
+
+	d->buf  = tmp;
+	d->size = size;
+	return 0;
+}
+
+/* Grows 'd' to fit at least 'needed' elements by the growth factor */
+static int darray_grow(darray_t *d, size_t needed) {
+	size_t size = d->size;
+	if (darray_mul_overflows(size, DARRAY_GROWTH_NUM))
+		size = SIZE_MAX / d->elem_size;
+	else
+		size = size * DARRAY_GROWTH_NUM / DARRAY_GROWTH_DEN;
+
+	if (size < DARRAY_CHUNK_SIZE)
+		size = DARRAY_CHUNK_SIZE;
+
+	if (size < needed)
+		size = needed;
+
+	return darray_realloc(d, size);
+}
+
 int darray_init(darray_t *d, size_t elem_size) {
+	return darray_init_cap(d, elem_size, DARRAY_CHUNK_SIZE);
+}
+
+int darray_init_cap(darray_t *d, size_t elem_size, size_t cap) {
+	return darray_init_with(d, elem_size, cap, NULL);
+}
+
+int darray_init_with(darray_t *d, size_t elem_size, size_t cap, const allocator_t *a) {
 	d->count     = 0;
-	d->size      = DARRAY_CHUNK_SIZE;
+	d->size      = 0;
 	d->elem_size = elem_size;
-	d->buf       = malloc(d->size * d->elem_size);
-	return d->buf == NULL? -1 : 0;
+	d->buf       = NULL;
+	d->allocator = a;
+	return cap == 0? 0 : darray_realloc(d, cap);
 }
 
 void darray_free(darray_t *d) {
-	free(d->buf);
+	allocator_free(d->allocator, d->buf);
 	d->count = 0;
 	d->size  = 0;
 	d->buf   = NULL;
@@ -147,13 +791,8 @@ void darray_free(darray_t *d) {
 
 int darray_add(darray_t *d, void *data) {
 	if (d->count >= d->size) {
-		d->size  *= 2;
-		void *tmp = realloc(d->buf, d->size);
-		if (tmp == NULL) {
-			free(d->buf);
+		if (darray_grow(d, d->count + 1) != 0)
 			return -1;
-		} else
-			d->buf = tmp;
 	}
 
 	memcpy((void*)((char*)d->buf + d->count * d->elem_size), data, d->elem_size);
@@ -168,6 +807,338 @@ void *darray_at(darray_t *d, size_t idx) {
 		return (void*)((char*)d->buf + idx * d->elem_size);
 }
 
+int darray_reserve(darray_t *d, size_t size) {
+	if (size <= d->size)
+		return 0;
+
+	return darray_realloc(d, size);
+}
+
+int darray_resize(darray_t *d, size_t count) {
+	if (count > d->size) {
+		if (darray_grow(d, count) != 0)
+			return -1;
+	}
+
+	if (count > d->count)
+		memset((char*)d->buf + d->count * d->elem_size, 0, (count - d->count) * d->elem_size);
+
+	d->count = count;
+	return 0;
+}
+
+int darray_shrink_to_fit(darray_t *d) {
+	if (d->count == d->size)
+		return 0;
+
+	/* realloc with size 0 is implementation defined, so an empty darray frees its buffer */
+	if (d->count == 0) {
+		allocator_free(d->allocator, d->buf);
+		d->buf  = NULL;
+		d->size = 0;
+		return 0;
+	}
+
+	return darray_realloc(d, d->count);
+}
+
+int darray_extend(darray_t *d, const void *data, size_t n) {
+	return darray_insert_range(d, d->count, data, n);
+}
+
+int darray_insert_range(darray_t *d, size_t idx, const void *data, size_t n) {
+	if (idx > d->count || n > SIZE_MAX - d->count)
+		return -1;
+
+	if (n == 0)
+		return 0;
+
+	/* 'data' might point into the buffer, which can be moved by the growth and by making room for
+	   the elements, so its offset is remembered instead */
+	uintptr_t begin = (uintptr_t)d->buf, addr = (uintptr_t)data;
+	size_t    bytes = d->count * d->elem_size, len = n * d->elem_size, off = addr - begin;
+	bool      alias = d->buf != NULL && addr >= begin && addr < begin + bytes;
+
+	if (d->count + n > d->size) {
+		if (darray_grow(d, d->count + n) != 0)
+			return -1;
+	}
+
+	char *at = (char*)d->buf + idx * d->elem_size;
+	if (idx < d->count)
+		memmove(at + len, at, (d->count - idx) * d->elem_size);
+
+	if (alias) {
+		/* The part of 'data' from 'idx' on was moved by 'len' bytes */
+		size_t split = idx * d->elem_size, before = off < split? split - off : 0;
+		if (before > len)
+			before = len;
+
+		memcpy(at, (char*)d->buf + off, before);
+		memcpy(at + before, (char*)d->buf + off + before + len, len - before);
+	} else
+		memcpy(at, data, len);
+
+	d->count += n;
+	return 0;
+}
+
+int darray_remove_range(darray_t *d, size_t idx, size_t n) {
+	if (idx > d->count || n > d->count - idx)
+		return -1;
+
+	char *at = (char*)d->buf + idx * d->elem_size;
+	if (idx + n < d->count)
+		memmove(at, at + n * d->elem_size, (d->count - idx - n) * d->elem_size);
+
+	d->count -= n;
+	return 0;
+}
+
+int darray_swap_remove(darray_t *d, size_t idx) {
+	if (idx >= d->count)
+		return -1;
+
+	-- d->count;
+	if (idx != d->count)
+		memcpy((char*)d->buf + idx * d->elem_size, (char*)d->buf + d->count * d->elem_size,
+		       d->elem_size);
+
+	return 0;
+}
+
+void darray_sort(darray_t *d, darray_cmp_t cmp) {
+	if (d->count > 1)
+		qsort(d->buf, d->count, d->elem_size, cmp);
+}
+
+void *darray_bsearch(darray_t *d, const void *key, darray_cmp_t cmp) {
+	size_t idx = darray_lower_bound(d, key, cmp);
+	if (idx >= d->count)
+		return NULL;
+
+	void *elem = (char*)d->buf + idx * d->elem_size;
+	return cmp(key, elem) == 0? elem : NULL;
+}
+
+size_t darray_lower_bound(darray_t *d, const void *key, darray_cmp_t cmp) {
+	size_t lo = 0, n = d->count;
+	while (n > 0) {
+		size_t half = n / 2;
+		if (cmp((char*)d->buf + (lo + half) * d->elem_size, key) < 0) {
+			lo += half + 1;
+			n  -= half + 1;
+		} else
+			n = half;
+	}
+
+	return lo;
+}
+
+/* Loads the element at 'elem' as a key, which sorts as an unsigned integer */
+static uint64_t darray_radix_key(const void *elem, size_t size, darray_key_t key) {
+	uint64_t x;
+	switch (size) {
+	case 1: { uint8_t  v; memcpy(&v, elem, 1); x = v; } break;
+	case 2: { uint16_t v; memcpy(&v, elem, 2); x = v; } break;
+	case 4: { uint32_t v; memcpy(&v, elem, 4); x = v; } break;
+	default: memcpy(&x, elem, 8);
+	}
+
+	uint64_t sign = (uint64_t)1 << (size * 8 - 1);
+	switch (key) {
+	case DARRAY_KEY_INT: return x ^ sign;
+	/* Negative floats have all their bits flipped to reverse their order, positive ones only
+	   the sign bit */
+	case DARRAY_KEY_FLOAT: {
+		uint64_t mask = size == 8? UINT64_MAX : ((uint64_t)1 << (size * 8)) - 1;
+		return x & sign? ~x & mask : x | sign;
+	}
+
+	default: return x;
+	}
+}
+
+int darray_radix_sort(darray_t *d, darray_key_t key) {
+	size_t size = d->elem_size;
+	if ((size != 1 && size != 2 && size != 4 && size != 8) ||
+	    (key == DARRAY_KEY_FLOAT && size != 4 && size != 8))
+		return -1;
+
+	if (d->count < 2)
+		return 0;
+
+	char *tmp = (char*)allocator_alloc(d->allocator, d->count * size);
+	if (tmp == NULL)
+		return -1;
+
+	/* Count the histograms of all the bytes in a single pass */
+	size_t (*hist)[256] = (size_t(*)[256])allocator_alloc(d->allocator,
+	                                                       sizeof(*hist) * size);
+	if (hist == NULL) {
+		allocator_free(d->allocator, tmp);
+		return -1;
+	}
+
+	memset(hist, 0, sizeof(*hist) * size);
+	for (size_t i = 0; i < d->count; ++ i) {
+		uint64_t x = darray_radix_key((char*)d->buf + i * size, size, key);
+		for (size_t b = 0; b < size; ++ b)
+			++ hist[b][(x >> (b * 8)) & 0xFF];
+	}
+
+	char *src = (char*)d->buf, *dst = tmp;
+	for (size_t b = 0; b < size; ++ b) {
+		/* All the elements have the same byte here, so this pass would not move anything */
+		if (hist[b][(darray_radix_key(src, size, key) >> (b * 8)) & 0xFF] == d->count)
+			continue;
+
+		size_t offset = 0;
+		for (size_t i = 0; i < 256; ++ i) {
+			size_t count = hist[b][i];
+			hist[b][i] = offset;
+			offset    += count;
+		}
+
+		for (size_t i = 0; i < d->count; ++ i) {
+			const char *elem = src + i * size;
+			size_t      byte = (darray_radix_key(elem, size, key) >> (b * 8)) & 0xFF;
+			memcpy(dst + hist[b][byte] ++ * size, elem, size);
+		}
+
+		char *swap = src;
+		src = dst;
+		dst = swap;
+	}
+
+	if (src != d->buf)
+		memcpy(d->buf, src, d->count * size);
+
+	allocator_free(d->allocator, hist);
+	allocator_free(d->allocator, tmp);
+	return 0;
+}
+
+#ifdef DARRAY_PARALLEL
+typedef struct {
+	darray_for_t fn;
+	void        *ctx, *elems;
+	size_t       count;
+} darray_chunk_t;
+
+#ifdef WIN32
+static DWORD WINAPI darray_chunk_run(LPVOID data) {
+	darray_chunk_t *chunk = (darray_chunk_t*)data;
+	chunk->fn(chunk->elems, chunk->count, chunk->ctx);
+	return 0;
+}
+#else
+static void *darray_chunk_run(void *data) {
+	darray_chunk_t *chunk = (darray_chunk_t*)data;
+	chunk->fn(chunk->elems, chunk->count, chunk->ctx);
+	return NULL;
+}
+#endif
+
+static size_t darray_cpu_count(void) {
+#ifdef WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+#else
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count < 1? 1 : (size_t)count;
+#endif
+}
+
+/* Rounds the index 'idx' up, so that its element starts on a cache line */
+static size_t darray_align_idx(darray_t *d, size_t idx) {
+	uintptr_t addr    = (uintptr_t)d->buf + idx * d->elem_size;
+	uintptr_t aligned = (addr + DARRAY_CACHE_LINE - 1) & ~(uintptr_t)(DARRAY_CACHE_LINE - 1);
+
+	idx += (aligned - addr + d->elem_size - 1) / d->elem_size;
+	return idx > d->count? d->count : idx;
+}
+
+void darray_parallel_for(darray_t *d, size_t jobs, darray_for_t fn, void *ctx) {
+	if (jobs == 0)
+		jobs = darray_cpu_count();
+
+	if (jobs > DARRAY_MAX_JOBS)
+		jobs = DARRAY_MAX_JOBS;
+
+	/* Starting a thread only pays off with enough work, and at least a cache line of elements */
+	size_t min_chunk = DARRAY_CACHE_LINE / d->elem_size;
+	if (min_chunk < DARRAY_MIN_CHUNK)
+		min_chunk = DARRAY_MIN_CHUNK;
+	if (min_chunk == 0)
+		min_chunk = 1;
+
+	if (jobs > d->count / min_chunk)
+		jobs = d->count / min_chunk;
+
+	if (jobs <= 1) {
+		if (d->count > 0)
+			fn(d->buf, d->count, ctx);
+
+		return;
+	}
+
+	darray_chunk_t chunks[DARRAY_MAX_JOBS];
+#ifdef WIN32
+	HANDLE    threads[DARRAY_MAX_JOBS];
+#else
+	pthread_t threads[DARRAY_MAX_JOBS];
+#endif
+	bool started[DARRAY_MAX_JOBS];
+
+	size_t begin = 0;
+	for (size_t i = 0; i < jobs; ++ i) {
+		size_t end = i + 1 == jobs? d->count : darray_align_idx(d, d->count / jobs * (i + 1));
+		if (end < begin)
+			end = begin;
+
+		chunks[i].fn    = fn;
+		chunks[i].ctx   = ctx;
+		chunks[i].elems = (char*)d->buf + begin * d->elem_size;
+		chunks[i].count = end - begin;
+		begin = end;
+	}
+
+	/* The first chunk runs on the calling thread */
+	for (size_t i = 1; i < jobs; ++ i) {
+		if (chunks[i].count == 0) {
+			started[i] = false;
+			continue;
+		}
+
+#ifdef WIN32
+		threads[i] = CreateThread(NULL, 0, darray_chunk_run, &chunks[i], 0, NULL);
+		started[i] = threads[i] != NULL;
+#else
+		started[i] = pthread_create(&threads[i], NULL, darray_chunk_run, &chunks[i]) == 0;
+#endif
+		if (!started[i])
+			darray_chunk_run(&chunks[i]);
+	}
+
+	if (chunks[0].count > 0)
+		darray_chunk_run(&chunks[0]);
+
+	for (size_t i = 1; i < jobs; ++ i) {
+		if (!started[i])
+			continue;
+
+#ifdef WIN32
+		WaitForSingleObject(threads[i], INFINITE);
+		CloseHandle(threads[i]);
+#else
+		pthread_join(threads[i], NULL);
+#endif
+	}
+}
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,48 @@
+#include <stdio.h> /* printf */
+
+#include <alloc.h>
+
+#define CHOL_DARRAY_IMPLEMENTATION
+#include <darray.h>
+
+/* a tracking allocator which counts the allocation calls and wraps libc */
+typedef struct {
+	size_t allocs, reallocs, frees;
+} stats_t;
+
+static void *tracking_alloc(void *ctx, size_t size) {
+	++ ((stats_t*)ctx)->allocs;
+	return malloc(size);
+}
+
+static void *tracking_realloc(void *ctx, void *ptr, size_t size) {
+	++ ((stats_t*)ctx)->reallocs;
+	return realloc(ptr, size);
+}
+
+static void tracking_free(void *ctx, void *ptr) {
+	++ ((stats_t*)ctx)->frees;
+	free(ptr);
+}
+
+int main(void) {
+	stats_t     stats = {0, 0, 0};
+	allocator_t a;
+	a.alloc   = tracking_alloc;
+	a.realloc = tracking_realloc;
+	a.free    = tracking_free;
+	a.ctx     = &stats;
+
+	darray_t nums;
+	if (darray_init_with(&nums, sizeof(int), 0, &a) != 0)
+		return 1;
+
+	for (int i = 0; i < 1000; ++ i)
+		DARRAY_ADD(&nums, &i);
+
+	DARRAY_FREE(&nums);
+
+	printf("allocs = %zu, reallocs = %zu, frees = %zu\n",
+	       stats.allocs, stats.reallocs, stats.frees);
+	return 0;
+}
@@ -0,0 +1,59 @@
+#include <stdio.h> /* printf */
+
+#define DARRAY_PARALLEL
+#define CHOL_DARRAY_IMPLEMENTATION
+#define CHOL_APPENDBUF_IMPLEMENTATION
+#include <appendbuf.h>
+
+static int is_prime(int n) {
+	if (n < 2)
+		return 0;
+
+	for (int i = 2; i * i <= n; ++ i) {
+		if (n % i == 0)
+			return 0;
+	}
+
+	return 1;
+}
+
+/* runs on many threads at once, all of them push into the same buffer without a lock */
+static void collect_primes(void *elems, size_t count, void *ctx) {
+	int *nums = (int*)elems;
+	for (size_t i = 0; i < count; ++ i) {
+		if (is_prime(nums[i]))
+			appendbuf_push((appendbuf_t*)ctx, &nums[i]);
+	}
+}
+
+int main(void) {
+	darray_t nums;
+	if (DARRAY_INIT(&nums, int) != 0 || darray_resize(&nums, 200000) != 0)
+		return 1;
+
+	int n = 0;
+	FOREACH_IN_DARRAY_UNCHECKED(&nums, int, num, {
+		*num = n ++;
+	});
+
+	appendbuf_t buf;
+	APPENDBUF_INIT(&buf, int);
+
+	darray_parallel_for(&nums, 0, collect_primes, &buf);
+
+	/* all the threads are done, freeze the results into a darray */
+	darray_t primes;
+	DARRAY_INIT(&primes, int);
+	if (appendbuf_freeze(&buf, &primes) != 0)
+		return 1;
+
+	/* the order depends on the threads, so sort the primes */
+	darray_radix_sort(&primes, DARRAY_KEY_INT);
+	printf("%zu primes, the last is %i\n", primes.count,
+	       *DARRAY_AT(&primes, primes.count - 1, int));
+
+	appendbuf_free(&buf);
+	DARRAY_FREE(&primes);
+	DARRAY_FREE(&nums);
+	return 0;
+}
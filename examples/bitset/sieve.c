@@ -0,0 +1,54 @@
+#include <stdio.h> /* printf */
+
+#define CHOL_BITSET_IMPLEMENTATION
+#include <bitset.h>
+
+#define LIMIT 1000000
+
+int main(void) {
+	/* sieve of Eratosthenes over a million bits, 125 KB instead of 1 MB of bool */
+	bitset_t primes;
+	bitset_init(&primes);
+	if (bitset_resize(&primes, LIMIT) != 0)
+		return 1;
+
+	bitset_set_all(&primes);
+	bitset_clear(&primes, 0);
+	bitset_clear(&primes, 1);
+	for (size_t i = 2; i * i < LIMIT; ++ i) {
+		if (!bitset_test(&primes, i))
+			continue;
+
+		for (size_t j = i * i; j < LIMIT; j += i)
+			bitset_clear(&primes, j);
+	}
+
+	printf("%zu primes below %i\n", bitset_count(&primes), LIMIT);
+	printf("%zu primes below 1000\n", bitset_rank(&primes, 1000));
+	printf("first prime after 500000: %zu\n", bitset_find_next(&primes, 500000));
+
+	/* primes that are 1 more than a multiple of 4 */
+	bitset_t ones;
+	bitset_init(&ones);
+	if (bitset_resize(&ones, LIMIT) != 0)
+		return 1;
+
+	for (size_t i = 1; i < LIMIT; i += 4)
+		bitset_set(&ones, i);
+
+	bitset_and(&ones, &primes);
+	printf("%zu of them are 4k + 1:", bitset_count(&ones));
+
+	size_t shown = 0;
+	FOREACH_SET_IN_BITSET(&ones, i, {
+		if (shown ++ >= 8)
+			break;
+
+		printf(" %zu", i);
+	});
+	printf(" ...\n");
+
+	bitset_free(&ones);
+	bitset_free(&primes);
+	return 0;
+}
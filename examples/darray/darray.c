@@ -23,6 +23,33 @@ int main(void) {
 	size_t idx = 2;
 	printf("\nnums[%zu] = %i\n", idx, *DARRAY_AT(&nums, idx, int));
 
+	/* reserve the space for a bulk load up front, so that it is allocated only once */
+	size_t count = 1000;
+	if (darray_reserve(&nums, nums.count + count) != 0)
+		return 1;
+
+	for (size_t i = 0; i < count; ++ i)
+		DARRAY_ADD_LIT(&nums, (int)i, int);
+
+	printf("count = %zu, size = %zu\n", nums.count, nums.size);
+
+	/* bulk operations move all the elements at once */
+	int more[] = {-1, -2, -3};
+	if (darray_extend(&nums, more, sizeof(more) / sizeof(*more)) != 0)
+		return 1;
+
+	darray_remove_range(&nums, 4, count);
+	darray_swap_remove(&nums, 0);
+
+	printf("nums = {");
+	FOREACH_IN_DARRAY(&nums, int, num, {
+		printf(" %i", *num);
+	});
+	printf(" }\n");
+
+	darray_shrink_to_fit(&nums);
+	printf("after shrink: size = %zu\n", nums.size);
+
 	DARRAY_FREE(&nums);
 	return 0;
 }
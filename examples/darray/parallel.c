@@ -0,0 +1,36 @@
+#include <stdio.h> /* printf */
+
+#define DARRAY_PARALLEL
+#define CHOL_DARRAY_IMPLEMENTATION
+#include <darray.h>
+
+/* called on each chunk from a worker thread */
+static void scale(void *elems, size_t count, void *ctx) {
+	float *xs = (float*)elems, factor = *(float*)ctx;
+	for (size_t i = 0; i < count; ++ i)
+		xs[i] *= factor;
+}
+
+int main(void) {
+	darray_t xs;
+	if (DARRAY_INIT(&xs, float) != 0 || darray_resize(&xs, 1000000) != 0)
+		return 1;
+
+	float i = 0;
+	FOREACH_IN_DARRAY_UNCHECKED(&xs, float, x, {
+		*x = i ++;
+	});
+
+	float factor = 0.5f;
+	darray_parallel_for(&xs, 0, scale, &factor);
+
+	double sum = 0;
+	FOREACH_IN_DARRAY_UNCHECKED(&xs, float, x, {
+		sum += *x;
+	});
+
+	printf("sum = %.1f\n", sum);
+
+	DARRAY_FREE(&xs);
+	return 0;
+}
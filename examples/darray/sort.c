@@ -0,0 +1,59 @@
+#include <stdio.h> /* printf */
+
+#define CHOL_DARRAY_IMPLEMENTATION
+#include <darray.h>
+
+#define INT_LESS(A, B) ((A) < (B))
+
+/* defines ints_sort, ints_lower_bound and ints_bsearch with the comparison inlined */
+DARRAY_DEFINE_SORT(ints, int, INT_LESS)
+
+static int cmp_int(const void *a, const void *b) {
+	int x = *(const int*)a, y = *(const int*)b;
+	return (x > y) - (x < y);
+}
+
+static void print(const char *title, darray_t *d) {
+	printf("%s = {", title);
+	FOREACH_IN_DARRAY(d, int, num, {
+		printf(" %i", *num);
+	});
+	printf(" }\n");
+}
+
+int main(void) {
+	int data[] = {42, -7, 19, 0, 3, -100, 19, 64, 5, 1};
+	size_t n   = sizeof(data) / sizeof(*data);
+
+	darray_t nums;
+	if (DARRAY_INIT(&nums, int) != 0 || darray_extend(&nums, data, n) != 0)
+		return 1;
+
+	/* generic sort with a qsort comparator */
+	darray_sort(&nums, cmp_int);
+	print("darray_sort", &nums);
+
+	int key = 19;
+	printf("lower_bound(%i) = %zu, found = %s\n", key, darray_lower_bound(&nums, &key, cmp_int),
+	       darray_bsearch(&nums, &key, cmp_int) != NULL? "yes" : "no");
+
+	/* specialized introsort */
+	nums.count = 0;
+	darray_extend(&nums, data, n);
+	ints_sort((int*)nums.buf, nums.count);
+	print("ints_sort", &nums);
+
+	/* radix sort, no comparisons at all */
+	nums.count = 0;
+	darray_extend(&nums, data, n);
+	if (darray_radix_sort(&nums, DARRAY_KEY_INT) != 0)
+		return 1;
+
+	print("darray_radix_sort", &nums);
+
+	int *found = ints_bsearch((int*)nums.buf, nums.count, 4);
+	printf("4 %s\n", found == NULL? "not found" : "found");
+
+	DARRAY_FREE(&nums);
+	return 0;
+}
@@ -0,0 +1,43 @@
+#include <stdio.h> /* printf */
+
+#include <darray.h> /* DARRAY_DEFINE does not need the implementation */
+
+/* defines the type floats_t and its functions floats_init, floats_push... */
+DARRAY_DEFINE(floats, float)
+
+/* stores up to 4 ints inline, without allocating */
+DARRAY_DEFINE_SMALL(small_ints, int, 4)
+
+int main(void) {
+	floats_t xs;
+	floats_init(&xs);
+
+	for (int i = 0; i < 10; ++ i) {
+		if (floats_push(&xs, (float)i * 0.5f) != 0)
+			return 1;
+	}
+
+	/* a plain loop over 'float *', which the compiler can vectorize */
+	float *data = floats_data(&xs), sum = 0;
+	for (size_t i = 0; i < xs.count; ++ i)
+		sum += data[i];
+
+	printf("sum = %f\n", sum);
+	printf("xs[3] = %f\n", *floats_at(&xs, 3));
+	float last = floats_pop(&xs);
+	printf("popped %f, %zu left\n", last, xs.count);
+
+	floats_free(&xs);
+
+	small_ints_t ys;
+	small_ints_init(&ys);
+	for (int i = 0; i < 6; ++ i) {
+		if (small_ints_push(&ys, i) != 0)
+			return 1;
+
+		printf("ys: count = %zu, inline = %s\n", ys.count, small_ints_is_small(&ys)? "yes" : "no");
+	}
+
+	small_ints_free(&ys);
+	return 0;
+}
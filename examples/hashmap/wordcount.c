@@ -0,0 +1,61 @@
+#include <stdio.h> /* printf */
+#include <ctype.h> /* isalpha */
+
+#include <hashmap.h>
+
+HASHMAP_DEFINE_SV(counts, int)
+HASHMAP_DEFINE(squares, int, int, HASHMAP_HASH_INT, HASHMAP_EQ)
+
+static const char *text =
+	"the quick brown fox jumps over the lazy dog and the lazy dog sleeps while the fox runs";
+
+int main(void) {
+	counts_t words;
+	counts_init(&words);
+
+	/* the keys point into 'text', the map does not copy them */
+	for (const char *it = text; *it != '\0';) {
+		if (!isalpha((unsigned char)*it)) {
+			++ it;
+			continue;
+		}
+
+		const char *start = it;
+		while (isalpha((unsigned char)*it))
+			++ it;
+
+		int *count = counts_put(&words, sv_new(start, (size_t)(it - start)));
+		if (count == NULL)
+			return 1;
+
+		++ *count;
+	}
+
+	FOREACH_IN_HASHMAP(&words, counts, e, {
+		if (e->value > 1)
+			printf(SV_FMT": %i\n", SV_ARG(e->key), e->value);
+	});
+
+	printf("%zu unique words\n", words.count);
+	counts_free(&words);
+
+	squares_t sq;
+	squares_init(&sq);
+	if (squares_reserve(&sq, 1000) != 0)
+		return 1;
+
+	for (int i = 0; i < 1000; ++ i) {
+		if (squares_set(&sq, i, i * i) != 0)
+			return 1;
+	}
+
+	/* erased slots are reused by later inserts */
+	for (int i = 0; i < 1000; i += 2)
+		squares_erase(&sq, i);
+
+	printf("count = %zu, 7^2 = %i, 8 erased: %s\n", sq.count, *squares_get(&sq, 7),
+	       squares_get(&sq, 8) == NULL? "yes" : "no");
+
+	squares_free(&sq);
+	return 0;
+}
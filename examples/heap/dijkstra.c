@@ -0,0 +1,74 @@
+#include <stdio.h> /* printf */
+
+#define CHOL_DARRAY_IMPLEMENTATION
+#include <heap.h>
+
+#define INT_LESS(A, B) ((A) < (B))
+
+HEAP_DEFINE(ints, int, INT_LESS)
+HEAP_DEFINE_INDEXED(frontier, int, INT_LESS)
+
+#define NODES 6
+
+/* edge weights, 0 means no edge */
+static const int graph[NODES][NODES] = {
+	{0, 7, 9, 0, 0, 14},
+	{7, 0, 10, 15, 0, 0},
+	{9, 10, 0, 11, 0, 2},
+	{0, 15, 11, 0, 6, 0},
+	{0, 0, 0, 6, 0, 9},
+	{14, 0, 2, 0, 9, 0},
+};
+
+int main(void) {
+	/* build a heap from an existing array in O(n) */
+	darray_t nums;
+	DARRAY_INIT(&nums, int);
+
+	int values[] = {42, 7, 19, 3, 25, 11, 8};
+	darray_extend(&nums, values, sizeof(values) / sizeof(*values));
+
+	ints_t h;
+	ints_init(&h);
+	if (ints_from_darray(&h, &nums) != 0)
+		return 1;
+
+	int num;
+	printf("sorted:");
+	while (ints_pop(&h, &num) == 0)
+		printf(" %i", num);
+	printf("\n");
+	ints_free(&h);
+
+	/* shortest paths, the node ids are the handles */
+	int dist[NODES];
+	for (int i = 0; i < NODES; ++ i)
+		dist[i] = -1;
+
+	frontier_t f;
+	frontier_init(&f);
+	if (frontier_push(&f, 0, 0) != 0)
+		return 1;
+
+	size_t node;
+	int    d;
+	while (frontier_pop(&f, &node, &d) == 0) {
+		dist[node] = d;
+		for (size_t to = 0; to < NODES; ++ to) {
+			if (graph[node][to] == 0 || dist[to] != -1)
+				continue;
+
+			int *known = frontier_get(&f, to);
+			if (known == NULL)
+				frontier_push(&f, to, d + graph[node][to]);
+			else if (d + graph[node][to] < *known)
+				frontier_decrease_key(&f, to, d + graph[node][to]);
+		}
+	}
+
+	for (int i = 0; i < NODES; ++ i)
+		printf("0 -> %i: %i\n", i, dist[i]);
+
+	frontier_free(&f);
+	return 0;
+}
@@ -0,0 +1,35 @@
+#include <stdio.h> /* printf */
+
+#define CHOL_MMARRAY_IMPLEMENTATION
+#include <mmarray.h>
+
+#define PATH "bin/persist.bin"
+
+typedef struct {
+	int    run;
+	double value;
+} record_t;
+
+int main(void) {
+	/* the records of the previous runs are mapped back without any reading or parsing */
+	mmarray_t records;
+	if (MMARRAY_OPEN(&records, PATH, record_t) != 0) {
+		fprintf(stderr, "Could not open '%s'\n", PATH);
+		return 1;
+	}
+
+	printf("'%s' has %zu records from previous runs\n", PATH, records.count);
+
+	/* append this run's records */
+	int run = records.count == 0? 1 : MMARRAY_AT(&records, records.count - 1, record_t)->run + 1;
+	for (int i = 0; i < 1000; ++ i) {
+		record_t r = {run, (double)i / 4};
+		if (mmarray_add(&records, &r) != 0)
+			return 1;
+	}
+
+	printf("run %i, now %zu records (capacity %zu)\n", run, records.count, records.size);
+
+	mmarray_close(&records);
+	return 0;
+}
@@ -0,0 +1,47 @@
+#include <stdio.h> /* printf */
+
+#define CHOL_RING_IMPLEMENTATION
+#include <ring.h>
+
+int main(void) {
+	/* a growable FIFO queue */
+	ring_t queue;
+	RING_INIT(&queue, int);
+
+	int nums[] = {1, 2, 3, 4, 5, 6, 7, 8};
+	if (ring_push_back_n(&queue, nums, sizeof(nums) / sizeof(*nums)) != 0)
+		return 1;
+
+	int zero = 0;
+	ring_push_front(&queue, &zero);
+
+	int out[4];
+	ring_pop_front_n(&queue, out, 4);
+	printf("popped %i %i %i %i, %zu left\n", out[0], out[1], out[2], out[3], queue.count);
+
+	int last;
+	ring_pop_back(&queue, &last);
+	printf("last = %i, front = %i\n", last, *RING_AT(&queue, 0, int));
+
+	ring_free(&queue);
+
+	/* a fixed capacity buffer keeping the last 4 values */
+	ring_t window;
+	if (RING_INIT_FIXED(&window, int, 4) != 0)
+		return 1;
+
+	for (int i = 0; i < 10; ++ i) {
+		if (window.count == window.size)
+			ring_pop_front(&window, NULL);
+
+		ring_push_back(&window, &i);
+	}
+
+	printf("window = {");
+	for (size_t i = 0; i < window.count; ++ i)
+		printf(" %i", *RING_AT(&window, i, int));
+	printf(" }\n");
+
+	ring_free(&window);
+	return 0;
+}
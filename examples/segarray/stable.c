@@ -0,0 +1,43 @@
+#include <stdio.h> /* printf */
+
+#define CHOL_SEGARRAY_IMPLEMENTATION
+#include <segarray.h>
+
+typedef struct {
+	const char *name;
+	int         age;
+} person_t;
+
+int main(void) {
+	segarray_t people;
+	SEGARRAY_INIT(&people, person_t);
+
+	/* keep a pointer to the first element */
+	person_t  first = {"Alice", 30};
+	person_t *alice = SEGARRAY_ADD(&people, &first, person_t);
+	if (alice == NULL)
+		return 1;
+
+	/* add enough elements to allocate many more blocks */
+	for (int i = 0; i < 100000; ++ i) {
+		person_t p = {"Bob", i};
+		if (segarray_add(&people, &p) == NULL)
+			return 1;
+	}
+
+	/* the pointer is still valid, since the elements never move */
+	printf("%s is %i, count = %zu, blocks = %zu\n", alice->name, alice->age,
+	       people.count, people.blocks_count);
+
+	size_t idx = 54321;
+	printf("people[%zu].age = %i\n", idx, SEGARRAY_AT(&people, idx, person_t)->age);
+
+	long sum = 0;
+	FOREACH_IN_SEGARRAY(&people, person_t, p, {
+		sum += p->age;
+	});
+	printf("sum of ages = %li\n", sum);
+
+	SEGARRAY_FREE(&people);
+	return 0;
+}
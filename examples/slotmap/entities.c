@@ -0,0 +1,50 @@
+#include <stdio.h> /* printf */
+
+#define CHOL_DARRAY_IMPLEMENTATION
+#include <slotmap.h>
+
+typedef struct {
+	const char *name;
+	float       x, vel;
+} entity_t;
+
+SLOTMAP_DEFINE(entities, entity_t)
+
+int main(void) {
+	entities_t world;
+	entities_init(&world);
+
+	const char *names[] = {"player", "goblin", "orc", "bat", "slime"};
+	slotmap_handle_t handles[5];
+	for (int i = 0; i < 5; ++ i) {
+		entity_t e = {names[i], (float)i * 10, (float)i};
+		if (entities_add(&world, e, &handles[i]) != 0)
+			return 1;
+	}
+
+	/* removing moves the last entity into the hole, the other handles stay valid */
+	entities_remove(&world, handles[1]);
+	entities_remove(&world, handles[3]);
+
+	/* the iteration goes over a packed array, there are no holes to skip */
+	FOREACH_IN_SLOTMAP(&world, entity_t, e, {
+		e->x += e->vel;
+	});
+
+	entity_t *player = entities_get(&world, handles[0]);
+	printf("player at %.1f, slime at %.1f\n", player->x, entities_get(&world, handles[4])->x);
+	printf("goblin handle is %s\n", entities_get(&world, handles[1]) == NULL? "stale" : "valid");
+
+	/* a new entity reuses a free slot with a new generation */
+	entity_t e = {"bird", 0, 5};
+	slotmap_handle_t bird;
+	if (entities_add(&world, e, &bird) != 0)
+		return 1;
+
+	printf("bird: slot %u gen %u, goblin: slot %u gen %u, %zu alive\n",
+	       (unsigned)bird.idx, (unsigned)bird.gen, (unsigned)handles[1].idx,
+	       (unsigned)handles[1].gen, world.values.count);
+
+	entities_free(&world);
+	return 0;
+}
@@ -0,0 +1,36 @@
+#include <stdio.h> /* printf */
+
+#include <soa.h>
+
+/* each field gets its own column: x, y and vel are separate float arrays */
+#define PARTICLE_FIELDS(X) \
+	X(float, x) \
+	X(float, y) \
+	X(float, vel) \
+	X(int,   id)
+
+SOA_DEFINE(particles, PARTICLE_FIELDS)
+
+int main(void) {
+	particles_t ps;
+	particles_init(&ps);
+
+	for (int i = 0; i < 1000; ++ i) {
+		if (particles_push(&ps, (float)i, 0, (float)(i % 7) * 0.25f, i) != 0)
+			return 1;
+	}
+
+	/* this loop touches only the 'y' and 'vel' columns, the compiler can vectorize it */
+	float *y = ps.y, *vel = ps.vel;
+	for (size_t i = 0; i < ps.count; ++ i)
+		y[i] += vel[i];
+
+	particles_swap_remove(&ps, 0);
+
+	printf("count = %zu, size = %zu\n", ps.count, ps.size);
+	printf("ps[0] = {x = %f, y = %f, id = %i}\n", ps.x[0], ps.y[0], ps.id[0]);
+	printf("ps[3] = {x = %f, y = %f, id = %i}\n", ps.x[3], ps.y[3], ps.id[3]);
+
+	particles_free(&ps);
+	return 0;
+}
@@ -0,0 +1,33 @@
+#include <stdio.h>  /* printf */
+#include <stdlib.h> /* qsort */
+
+#define CHOL_SV_IMPLEMENTATION
+#include <sv.h>
+
+static int cmp_nocase(const void *a, const void *b) {
+	return sv_compare_nocase(*(const sv_t*)a, *(const sv_t*)b);
+}
+
+int main(void) {
+	sv_t words[] = {
+		sv_cstr("banana"), sv_cstr("Apple"), sv_cstr("apricot"), sv_cstr("cherry"),
+		sv_cstr("APPLE"),  sv_cstr("band"),
+	};
+	size_t count = sizeof(words) / sizeof(*words);
+
+	qsort(words, count, sizeof(*words), cmp_nocase);
+	for (size_t i = 0; i < count; ++ i)
+		printf(SV_FMT " ", SV_ARG(words[i]));
+	printf("\n");
+
+	sv_t a = sv_cstr("Apple"), b = sv_cstr("APPLE");
+	printf("'" SV_FMT "' == '" SV_FMT "': %i, ignoring case: %i\n", SV_ARG(a), SV_ARG(b),
+	       sv_is_equal(a, b), sv_is_equal_nocase(a, b));
+	printf("compare: %i\n", sv_compare(a, b) > 0);
+
+	sv_t path1 = sv_cstr("/usr/local/include/chol/sv.h");
+	sv_t path2 = sv_cstr("/usr/local/lib/libchol.a");
+	sv_t prefix = sv_substr(path1, 0, sv_common_prefix(path1, path2));
+	printf("common prefix: '" SV_FMT "'\n", SV_ARG(prefix));
+	return 0;
+}
@@ -26,9 +26,26 @@ void b(void) {
 	printf("    -> last  not at %zu\n", sv_find_last_not( sv, ch));
 }
 
+void c(void) {
+	const char *lines[] = {
+		"GET /index.html HTTP/1.1 200 OK (served from the cache)",
+		"GET /about.html HTTP/1.1 404 Not Found (not served from the cache)",
+		"GET /style.css HTTP/1.1 200 OK (not served from the cache, cache was invalidated)",
+	};
+
+	/* the needle is preprocessed once and reused for every line */
+	sv_searcher_t s;
+	sv_searcher_init(&s, sv_cstr("not served from the cache, cache was invalidated"));
+	printf("Searching for '" SV_FMT "':\n", SV_ARG(s.needle));
+
+	for (size_t i = 0; i < sizeof(lines) / sizeof(*lines); ++ i)
+		printf("  line %zu -> at %zu\n", i, sv_searcher_find(&s, sv_cstr(lines[i])));
+}
+
 int main(void) {
 	a();
 	b();
+	c();
 
 	return 0;
 }
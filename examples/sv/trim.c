@@ -9,5 +9,16 @@ int main(void) {
 	sv = sv_trim(sv, SV_WHITESPACES);
 	printf("'" SV_FMT "'\n", SV_ARG(sv));
 
+	/* build the set once and reuse it for every field */
+	sv_charset_t seps = sv_charset(",;");
+	sv_t line = sv_cstr("  alpha , beta;gamma ,  delta  ");
+	while (line.len > 0) {
+		size_t end   = sv_cspan(line, &seps);
+		sv_t   field = sv_trim_set(sv_substr(line, 0, end), SV_CHARSET_WHITESPACES);
+		printf("field '" SV_FMT "'\n", SV_ARG(field));
+
+		line = sv_substr(line, end == line.len? end : end + 1, SV_NPOS);
+	}
+
 	return 0;
 }
@@ -36,12 +36,12 @@ extern "C" {
 
 #include <stdbool.h> /* bool, true, false */
 #include <string.h>  /* strlen, strcpy, memcpy, strcat, memset */
-#include <stdlib.h>  /* malloc */
+#include <stdlib.h>  /* size_t */
 #include <stdarg.h>  /* va_list, va_start, va_end, va_arg */
 #include <stdint.h>  /* int64_t */
 
 #define CHOL_FS_VERSION_MAJOR 1
-#define CHOL_FS_VERSION_MINOR 8
+#define CHOL_FS_VERSION_MINOR 9
 #define CHOL_FS_VERSION_PATCH 2
 
 /*
@@ -57,9 +57,11 @@ extern "C" {
  *        the copy if it already exists and recopy
  * 1.7.2: Add fs_time
  * 1.8.2: Add fs_is_path_d_or_dd
+ * 1.9.2: Add fs_set_allocator
  */
 
 #include "sys.h"
+#include "alloc.h"
 
 #ifdef WIN32
 
@@ -170,6 +172,8 @@ char *fs_replace_ext(const char *path, const char *new_ext);
 
 int fs_read_link(const char *path, char *buf, size_t size, size_t *written);
 
+void fs_set_allocator(const allocator_t *a);
+
 /*
  * FS_JOIN_PATH(...)
  *     Joins together any number of strings '...' and separates them using PATH_SEP
@@ -203,6 +207,11 @@ int fs_read_link(const char *path, char *buf, size_t size, size_t *written);
  * int fs_read_link(const char *path, char *buf, size_t size, size_t *written)
  *     Reads the target path of link 'path' to the buffer 'buf' of size 'size'. If 'written' is not
  *     NULL, it contains the length of the target path.
+ *
+ * void fs_set_allocator(const allocator_t *a)
+ *     Makes the functions that return heap strings (fs_join_path, fs_remove_ext, fs_replace_ext)
+ *     allocate them with 'a' (see alloc.h). NULL restores the default libc allocator. The strings
+ *     then have to be freed with allocator_free(a, ...).
  */
 
 int fs_create_link(const char *path, const char *target, bool is_dir);
@@ -295,6 +304,12 @@ int fs_dir_next( fs_dir_t *d, fs_ent_t *e);
 extern "C" {
 #endif
 
+static const allocator_t *fs_allocator = NULL;
+
+void fs_set_allocator(const allocator_t *a) {
+	fs_allocator = a;
+}
+
 char *fs_join_path(const char *base, ...) {
 	size_t len = strlen(base);
 
@@ -309,7 +324,7 @@ char *fs_join_path(const char *base, ...) {
 	va_end(args);
 
 	/* Allocate memory and construct the path */
-	char *buf = (char*)malloc(len + 1);
+	char *buf = (char*)allocator_alloc(fs_allocator, len + 1);
 	if (buf == NULL)
 		return NULL;
 
@@ -436,7 +451,7 @@ char *fs_remove_ext(const char *path) {
 	const char *ext = fs_ext(path);
 	size_t len      = strlen(path) - strlen(ext) - 1;
 
-	char *removed = (char*)malloc(len + 1);
+	char *removed = (char*)allocator_alloc(fs_allocator, len + 1);
 	if (removed == NULL)
 		return NULL;
 
@@ -457,7 +472,7 @@ char *fs_replace_ext(const char *path, const char *new_ext) {
 	}
 
 	size_t ext_len = strlen(new_ext);
-	char  *str     = (char*)malloc(len + ext_len + 2);
+	char  *str     = (char*)allocator_alloc(fs_allocator, len + ext_len + 2);
 	if (str == NULL)
 		return NULL;
 
@@ -0,0 +1,448 @@
+/*
+ * This library is a part of the C header-only libraries collection
+ * (https://github.com/LordOfTrident/chol)
+ *
+ * This library has no implementation section, the hash maps are generated with a macro into
+ * static inline functions, so it can be included anywhere without defining an implementation
+ * macro.
+ *
+ * This library provides a generic open-addressing hash map. It uses SwissTable-style probing:
+ * besides the entries, the map keeps an array of control bytes (one per slot, holding 7 bits of
+ * the hash of its key), and a lookup compares a whole group of 16 control bytes at once (with SSE2
+ * where available), so only the entries whose control byte matches are compared by key.
+ */
+
+/* Simple example of the library:
+#include <stdio.h>
+
+#include <chol/hashmap.h>
+
+HASHMAP_DEFINE_SV(counts, int)
+
+int main(void) {
+	counts_t m;
+	counts_init(&m);
+
+	const char *words[] = {"foo", "bar", "foo"};
+	for (size_t i = 0; i < 3; ++ i)
+		++ *counts_put(&m, sv_cstr(words[i]));
+
+	printf("foo: %i\n", *counts_get(&m, sv_cstr("foo")));
+	counts_free(&m);
+	return 0;
+}
+*/
+
+#ifndef CHOL_HASHMAP_H_HEADER_GUARD
+#define CHOL_HASHMAP_H_HEADER_GUARD
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>  /* size_t */
+#include <string.h>  /* memcpy, memset, memcmp */
+#include <stdint.h>  /* uint8_t, uint64_t, SIZE_MAX */
+#include <stdbool.h> /* bool, true, false */
+
+#include "alloc.h"
+#include "sv.h"
+
+#if !defined(HASHMAP_NO_SIMD) && \
+    (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#	define HASHMAP_SSE2
+#	include <emmintrin.h> /* _mm_loadu_si128, _mm_cmpeq_epi8, _mm_movemask_epi8 */
+#endif
+
+#define CHOL_HASHMAP_VERSION_MAJOR 1
+#define CHOL_HASHMAP_VERSION_MINOR 0
+#define CHOL_HASHMAP_VERSION_PATCH 0
+
+/*
+ * 1.0.0: Open-addressing hash map with control bytes, sv_t keys
+ */
+
+#define HASHMAP_GROUP    16
+#define HASHMAP_MIN_SIZE 16
+#define HASHMAP_EMPTY    ((uint8_t)0x80)
+#define HASHMAP_DELETED  ((uint8_t)0xFE)
+
+/*
+ * HASHMAP_NO_SIMD
+ *     If defined before including, the control bytes are always matched with plain C instead of
+ *     SSE2.
+ *
+ * HASHMAP_GROUP
+ *     Count of control bytes matched at once.
+ *
+ * HASHMAP_EMPTY, HASHMAP_DELETED
+ *     Control bytes of empty and erased slots. A full slot holds the low 7 bits of its hash, so
+ *     all the special values have the high bit set.
+ */
+
+/* Returns a mask with a bit set for each of the HASHMAP_GROUP control bytes at 'ctrl' equal
+   to 'c' */
+static inline unsigned hashmap_match(const uint8_t *ctrl, uint8_t c) {
+#ifdef HASHMAP_SSE2
+	__m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+	return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)c)));
+#else
+	unsigned mask = 0;
+	for (unsigned i = 0; i < HASHMAP_GROUP; ++ i)
+		mask |= (unsigned)(ctrl[i] == c) << i;
+
+	return mask;
+#endif
+}
+
+/* Same as hashmap_match, but matches empty and erased slots */
+static inline unsigned hashmap_match_free(const uint8_t *ctrl) {
+#ifdef HASHMAP_SSE2
+	return (unsigned)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ctrl));
+#else
+	unsigned mask = 0;
+	for (unsigned i = 0; i < HASHMAP_GROUP; ++ i)
+		mask |= (unsigned)(ctrl[i] >> 7) << i;
+
+	return mask;
+#endif
+}
+
+/* Returns the index of the lowest set bit of 'x', which must not be 0 */
+static inline unsigned hashmap_ctz(unsigned x) {
+#if defined(__GNUC__) || defined(__clang__)
+	return (unsigned)__builtin_ctz(x);
+#else
+	unsigned idx = 0;
+	while ((x & 1) == 0) {
+		x >>= 1;
+		++ idx;
+	}
+
+	return idx;
+#endif
+}
+
+static inline uint64_t hashmap_hash_u64(uint64_t x) {
+	x ^= x >> 33;
+	x *= 0xFF51AFD7ED558CCDULL;
+	x ^= x >> 33;
+	x *= 0xC4CEB9FE1A85EC53ULL;
+	x ^= x >> 33;
+	return x;
+}
+
+static inline uint64_t hashmap_hash_bytes(const void *data, size_t size) {
+	const char *bytes = (const char*)data;
+	uint64_t    hash  = 0x9E3779B97F4A7C15ULL ^ size;
+	for (; size >= 8; size -= 8, bytes += 8) {
+		uint64_t k;
+		memcpy(&k, bytes, 8);
+		hash = (hash ^ hashmap_hash_u64(k)) * 0x9E3779B97F4A7C15ULL;
+	}
+
+	if (size > 0) {
+		uint64_t k = 0;
+		memcpy(&k, bytes, size);
+		hash = (hash ^ hashmap_hash_u64(k)) * 0x9E3779B97F4A7C15ULL;
+	}
+
+	return hashmap_hash_u64(hash);
+}
+
+static inline uint64_t hashmap_hash_sv(sv_t sv) {
+	return hashmap_hash_bytes(sv.cstr, sv.len);
+}
+
+static inline bool hashmap_eq_sv(sv_t a, sv_t b) {
+	return a.len == b.len && (a.len == 0 || memcmp(a.cstr, b.cstr, a.len) == 0);
+}
+
+#define HASHMAP_HASH_INT(X) hashmap_hash_u64((uint64_t)(X))
+#define HASHMAP_EQ(A, B)    ((A) == (B))
+
+/*
+ * uint64_t hashmap_hash_u64(uint64_t x)
+ *     Mixes the bits of 'x' (the MurmurHash3 finalizer). Used to hash integer keys.
+ *
+ * uint64_t hashmap_hash_bytes(const void *data, size_t size)
+ *     Hashes 'size' bytes of 'data', 8 bytes at a time.
+ *
+ * uint64_t hashmap_hash_sv(sv_t sv)
+ * bool hashmap_eq_sv(sv_t a, sv_t b)
+ *     Hash and equality functions for sv_t keys.
+ *
+ * HASHMAP_HASH_INT(X), HASHMAP_EQ(A, B)
+ *     Hash and equality macros for integer keys.
+ */
+
+#define HASHMAP_DEFINE(NAME, KEY, VALUE, HASH, EQ) \
+	typedef struct { \
+		KEY   key; \
+		VALUE value; \
+	} NAME##_entry_t; \
+	\
+	typedef struct { \
+		uint8_t        *ctrl; \
+		NAME##_entry_t *entries; \
+		size_t          count, size, growth_left; \
+		\
+		const allocator_t *allocator; \
+	} NAME##_t; \
+	\
+	static inline void NAME##_init_with(NAME##_t *m, const allocator_t *a) { \
+		m->ctrl        = NULL; \
+		m->entries     = NULL; \
+		m->count       = 0; \
+		m->size        = 0; \
+		m->growth_left = 0; \
+		m->allocator   = a; \
+	} \
+	\
+	static inline void NAME##_init(NAME##_t *m) { \
+		NAME##_init_with(m, NULL); \
+	} \
+	\
+	static inline void NAME##_free(NAME##_t *m) { \
+		allocator_free(m->allocator, m->entries); \
+		NAME##_init_with(m, m->allocator); \
+	} \
+	\
+	/* The last HASHMAP_GROUP control bytes mirror the first ones, so that a group can be loaded \
+	   at any slot without wrapping around */ \
+	static inline void NAME##_set_ctrl(NAME##_t *m, size_t idx, uint8_t c) { \
+		m->ctrl[idx] = c; \
+		if (idx < HASHMAP_GROUP) \
+			m->ctrl[m->size + idx] = c; \
+	} \
+	\
+	static inline size_t NAME##_find(const NAME##_t *m, KEY key, uint64_t hash) { \
+		if (m->size == 0) \
+			return SIZE_MAX; \
+		\
+		size_t  mask = m->size - 1, pos = (size_t)(hash >> 7) & mask, step = 0; \
+		uint8_t h2   = (uint8_t)(hash & 0x7F); \
+		for (;;) { \
+			for (unsigned match = hashmap_match(m->ctrl + pos, h2); match != 0; \
+			     match &= match - 1) { \
+				size_t idx = (pos + hashmap_ctz(match)) & mask; \
+				if (EQ(m->entries[idx].key, key)) \
+					return idx; \
+			} \
+			\
+			/* An empty slot ends the probe sequence, the key would have been placed there */ \
+			if (hashmap_match(m->ctrl + pos, HASHMAP_EMPTY) != 0) \
+				return SIZE_MAX; \
+			\
+			step += HASHMAP_GROUP; \
+			pos   = (pos + step) & mask; \
+		} \
+	} \
+	\
+	static inline size_t NAME##_find_free(const NAME##_t *m, uint64_t hash) { \
+		size_t mask = m->size - 1, pos = (size_t)(hash >> 7) & mask, step = 0; \
+		for (;;) { \
+			unsigned match = hashmap_match_free(m->ctrl + pos); \
+			if (match != 0) \
+				return (pos + hashmap_ctz(match)) & mask; \
+			\
+			step += HASHMAP_GROUP; \
+			pos   = (pos + step) & mask; \
+		} \
+	} \
+	\
+	static inline int NAME##_rehash(NAME##_t *m, size_t size) { \
+		if (size > (SIZE_MAX - HASHMAP_GROUP) / (sizeof(NAME##_entry_t) + 1)) \
+			return -1; \
+		\
+		NAME##_t new_ = *m; \
+		new_.size    = size; \
+		new_.entries = (NAME##_entry_t*)allocator_alloc(m->allocator, size * \
+		               sizeof(NAME##_entry_t) + size + HASHMAP_GROUP); \
+		if (new_.entries == NULL) \
+			return -1; \
+		\
+		new_.ctrl = (uint8_t*)(new_.entries + size); \
+		memset(new_.ctrl, HASHMAP_EMPTY, size + HASHMAP_GROUP); \
+		\
+		for (size_t i = 0; i < m->size; ++ i) { \
+			if (m->ctrl[i] & 0x80) \
+				continue; \
+			\
+			size_t idx = NAME##_find_free(&new_, HASH(m->entries[i].key)); \
+			NAME##_set_ctrl(&new_, idx, m->ctrl[i]); \
+			new_.entries[idx] = m->entries[i]; \
+		} \
+		\
+		new_.growth_left = size - size / 8 - m->count; \
+		allocator_free(m->allocator, m->entries); \
+		*m = new_; \
+		return 0; \
+	} \
+	\
+	static inline int NAME##_reserve(NAME##_t *m, size_t count) { \
+		size_t size = HASHMAP_MIN_SIZE; \
+		while (size - size / 8 < count) { \
+			if (size > SIZE_MAX / 2) \
+				return -1; \
+			\
+			size *= 2; \
+		} \
+		\
+		return size <= m->size? 0 : NAME##_rehash(m, size); \
+	} \
+	\
+	static inline void NAME##_clear(NAME##_t *m) { \
+		if (m->size == 0) \
+			return; \
+		\
+		memset(m->ctrl, HASHMAP_EMPTY, m->size + HASHMAP_GROUP); \
+		m->count       = 0; \
+		m->growth_left = m->size - m->size / 8; \
+	} \
+	\
+	static inline VALUE *NAME##_get(const NAME##_t *m, KEY key) { \
+		size_t idx = NAME##_find(m, key, HASH(key)); \
+		return idx == SIZE_MAX? NULL : &m->entries[idx].value; \
+	} \
+	\
+	static inline VALUE *NAME##_put(NAME##_t *m, KEY key) { \
+		uint64_t hash = HASH(key); \
+		size_t   idx  = NAME##_find(m, key, hash); \
+		if (idx != SIZE_MAX) \
+			return &m->entries[idx].value; \
+		\
+		if (m->growth_left == 0) { \
+			/* Grow if the map is really full, otherwise only clean up the erased slots */ \
+			size_t size = m->size == 0? HASHMAP_MIN_SIZE : m->size; \
+			if (m->count >= size / 2) { \
+				if (size > SIZE_MAX / 2) \
+					return NULL; \
+				\
+				size *= 2; \
+			} \
+			\
+			if (NAME##_rehash(m, size) != 0) \
+				return NULL; \
+		} \
+		\
+		idx = NAME##_find_free(m, hash); \
+		if (m->ctrl[idx] == HASHMAP_EMPTY) \
+			-- m->growth_left; \
+		\
+		NAME##_set_ctrl(m, idx, (uint8_t)(hash & 0x7F)); \
+		m->entries[idx].key = key; \
+		memset(&m->entries[idx].value, 0, sizeof(VALUE)); \
+		++ m->count; \
+		return &m->entries[idx].value; \
+	} \
+	\
+	static inline int NAME##_set(NAME##_t *m, KEY key, VALUE value) { \
+		VALUE *slot = NAME##_put(m, key); \
+		if (slot == NULL) \
+			return -1; \
+		\
+		*slot = value; \
+		return 0; \
+	} \
+	\
+	static inline bool NAME##_erase(NAME##_t *m, KEY key) { \
+		size_t idx = NAME##_find(m, key, HASH(key)); \
+		if (idx == SIZE_MAX) \
+			return false; \
+		\
+		NAME##_set_ctrl(m, idx, HASHMAP_DELETED); \
+		-- m->count; \
+		return true; \
+	}
+
+#define HASHMAP_DEFINE_SV(NAME, VALUE) \
+	HASHMAP_DEFINE(NAME, sv_t, VALUE, hashmap_hash_sv, hashmap_eq_sv)
+
+#define FOREACH_IN_HASHMAP(M, NAME, VAR, BODY) \
+	do { \
+		for (size_t _i = 0; _i < (M)->size; ++ _i) { \
+			if ((M)->ctrl[_i] & 0x80) \
+				continue; \
+			\
+			NAME##_entry_t *VAR = &(M)->entries[_i]; \
+			BODY \
+		} \
+	} while (0)
+
+/*
+ * HASHMAP_DEFINE(NAME, KEY, VALUE, HASH, EQ)
+ *     Defines a hash map type 'NAME'_t mapping keys of type 'KEY' to values of type 'VALUE', along
+ *     with its functions. 'HASH' is a function or macro taking a 'KEY' and returning its uint64_t
+ *     hash, 'EQ' a function or macro taking two keys and returning true if they are equal. Both
+ *     are expanded into the functions, so they are inlined. The keys and values are copied by
+ *     assignment, so for pointer or sv_t keys the map does not own the pointed to data. Example:
+ *         | HASHMAP_DEFINE(ids, int, const char*, HASHMAP_HASH_INT, HASHMAP_EQ)
+ *         |
+ *         | ids_t m;
+ *         | ids_init(&m);
+ *         | if (ids_set(&m, 5, "five") != 0)
+ *         |     FATAL_FUNC_FAIL("ids_set");
+ *
+ *     The map keeps at most 7/8 of its slots used (erased slots included), so a probe sequence
+ *     always ends at an empty slot.
+ *
+ *     'NAME'_entry_t
+ *         KEY key
+ *         VALUE value
+ *
+ *     'NAME'_t
+ *         uint8_t *ctrl
+ *             The control bytes, 'size' + HASHMAP_GROUP of them
+ *         'NAME'_entry_t *entries
+ *             The slots (the control bytes are in the same allocation, right after them)
+ *         size_t count
+ *             Count of entries
+ *         size_t size
+ *             Count of slots, a power of 2
+ *         size_t growth_left
+ *             Count of empty slots that can be filled before the map has to be rehashed
+ *         const allocator_t *allocator
+ *             The allocator of the map, NULL for libc (see alloc.h)
+ *
+ *     void 'NAME'_init('NAME'_t *m)
+ *         Initializes 'm' as empty. Does not allocate.
+ *
+ *     void 'NAME'_init_with('NAME'_t *m, const allocator_t *a)
+ *         Same as 'NAME'_init, but 'm' allocates with 'a'.
+ *
+ *     void 'NAME'_free('NAME'_t *m)
+ *         Frees 'm'.
+ *
+ *     int 'NAME'_reserve('NAME'_t *m, size_t count)
+ *         Makes sure 'm' can hold 'count' entries without rehashing. Returns 0 on success.
+ *
+ *     void 'NAME'_clear('NAME'_t *m)
+ *         Removes all the entries of 'm', keeping its slots.
+ *
+ *     VALUE *'NAME'_get('NAME'_t *m, KEY key)
+ *         Returns a pointer to the value of 'key' in 'm', or NULL if there is none.
+ *
+ *     VALUE *'NAME'_put('NAME'_t *m, KEY key)
+ *         Returns a pointer to the value of 'key' in 'm', inserting 'key' with a zero initialized
+ *         value if it is not there yet. Returns NULL on allocation fail. The pointer is
+ *         invalidated when 'm' rehashes.
+ *
+ *     int 'NAME'_set('NAME'_t *m, KEY key, VALUE value)
+ *         Sets the value of 'key' in 'm' to 'value'. Returns 0 on success.
+ *
+ *     bool 'NAME'_erase('NAME'_t *m, KEY key)
+ *         Removes 'key' from 'm'. Returns false if 'key' was not in 'm'.
+ *
+ * HASHMAP_DEFINE_SV(NAME, VALUE)
+ *     Defines a hash map with sv_t keys, compared by content.
+ *
+ * FOREACH_IN_HASHMAP(M, NAME, VAR, BODY)
+ *     Loops through each entry in the hash map 'M' of the type defined as 'NAME'. 'VAR' is the
+ *     name of the entry pointer variable, which is of type pointer to 'NAME'_entry_t, and 'BODY' is
+ *     the code to run on each iteration. The order of the entries is unspecified.
+ */
+
+#ifdef __cplusplus
+}
+#endif
+#endif
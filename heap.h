@@ -0,0 +1,414 @@
+/*
+ * This library is a part of the C header-only libraries collection
+ * (https://github.com/LordOfTrident/chol)
+ *
+ * This library has no implementation section, the heaps are generated with a macro into static
+ * inline functions. The elements are stored in a darray_t though, so the implementation of
+ * darray.h has to be included in one of the files:
+ *     #define CHOL_DARRAY_IMPLEMENTATION
+ *
+ * This library provides a d-ary heap priority queue. Push and pop are O(log n) instead of the
+ * O(n log n) re-sort of a sorted array, and a wider node (4 children by default) makes the heap
+ * shallower and keeps the children of a node in one cache line.
+ */
+
+/* Simple example of the library:
+#include <stdio.h>
+
+#define CHOL_DARRAY_IMPLEMENTATION
+#include <chol/heap.h>
+
+#define INT_LESS(A, B) ((A) < (B))
+HEAP_DEFINE(ints, int, INT_LESS)
+
+int main(void) {
+	ints_t h;
+	ints_init(&h);
+
+	ints_push(&h, 5);
+	ints_push(&h, 1);
+	ints_push(&h, 3);
+
+	int num;
+	while (ints_pop(&h, &num) == 0)
+		printf("%i\n", num); // 1 3 5
+
+	ints_free(&h);
+	return 0;
+}
+*/
+
+#ifndef CHOL_HEAP_H_HEADER_GUARD
+#define CHOL_HEAP_H_HEADER_GUARD
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>  /* size_t */
+#include <stdint.h>  /* SIZE_MAX */
+#include <stdbool.h> /* bool, true, false */
+
+#include "alloc.h"
+#include "darray.h"
+
+#define CHOL_HEAP_VERSION_MAJOR 1
+#define CHOL_HEAP_VERSION_MINOR 0
+#define CHOL_HEAP_VERSION_PATCH 0
+
+/*
+ * 1.0.0: D-ary heap over darray_t, indexed heap with decrease-key
+ */
+
+#ifndef HEAP_ARITY
+#	define HEAP_ARITY 4
+#endif
+
+#define HEAP_NPOS ((size_t)-1)
+
+/*
+ * HEAP_ARITY
+ *     Count of children of a heap node. If not defined before including, the default is 4.
+ *
+ * HEAP_NPOS
+ *     Position of a handle that is not in an indexed heap.
+ */
+
+#define HEAP_MOVED_NONE(H, ELEM, POS) (void)0
+#define HEAP_MOVED_INDEXED(H, ELEM, POS) (((size_t*)(H)->where.buf)[(ELEM).handle] = (POS))
+
+/* Functions shared by both heap kinds. 'MOVED' is called each time an element is placed at a
+   position, the indexed heap records the position of the handle with it */
+#define HEAP_DEFINE_COMMON(NAME, ELEM, LESS, MOVED) \
+	static inline int NAME##_reserve(NAME##_t *h, size_t size) { \
+		return darray_reserve(&h->items, size); \
+	} \
+	\
+	static inline void NAME##_sift_up(NAME##_t *h, size_t pos) { \
+		ELEM *a = (ELEM*)h->items.buf, x = a[pos]; \
+		while (pos > 0) { \
+			size_t parent = (pos - 1) / HEAP_ARITY; \
+			if (!LESS(x, a[parent])) \
+				break; \
+			\
+			a[pos] = a[parent]; \
+			MOVED(h, a[pos], pos); \
+			pos = parent; \
+		} \
+		\
+		a[pos] = x; \
+		MOVED(h, x, pos); \
+	} \
+	\
+	static inline void NAME##_sift_down(NAME##_t *h, size_t pos) { \
+		ELEM  *a = (ELEM*)h->items.buf, x = a[pos]; \
+		size_t n = h->items.count; \
+		for (;;) { \
+			size_t first = pos * HEAP_ARITY + 1; \
+			if (first >= n) \
+				break; \
+			\
+			size_t last = n - first > HEAP_ARITY? first + HEAP_ARITY : n, best = first; \
+			for (size_t i = first + 1; i < last; ++ i) { \
+				if (LESS(a[i], a[best])) \
+					best = i; \
+			} \
+			\
+			if (!LESS(a[best], x)) \
+				break; \
+			\
+			a[pos] = a[best]; \
+			MOVED(h, a[pos], pos); \
+			pos = best; \
+		} \
+		\
+		a[pos] = x; \
+		MOVED(h, x, pos); \
+	} \
+	\
+	/* Moves the element at 'pos' up or down after its value changed */ \
+	static inline void NAME##_fix(NAME##_t *h, size_t pos) { \
+		ELEM *a = (ELEM*)h->items.buf; \
+		if (pos > 0 && LESS(a[pos], a[(pos - 1) / HEAP_ARITY])) \
+			NAME##_sift_up(h, pos); \
+		else \
+			NAME##_sift_down(h, pos); \
+	} \
+	\
+	/* Removes the element at 'pos' and returns it */ \
+	static inline ELEM NAME##_remove_at(NAME##_t *h, size_t pos) { \
+		ELEM *a = (ELEM*)h->items.buf, x = a[pos]; \
+		if (pos != -- h->items.count) { \
+			a[pos] = a[h->items.count]; \
+			NAME##_fix(h, pos); \
+		} \
+		\
+		return x; \
+	}
+
+#define HEAP_DEFINE(NAME, TYPE, LESS) \
+	typedef struct { \
+		darray_t items; \
+	} NAME##_t; \
+	\
+	HEAP_DEFINE_COMMON(NAME, TYPE, LESS, HEAP_MOVED_NONE) \
+	\
+	static inline void NAME##_init_with(NAME##_t *h, const allocator_t *a) { \
+		darray_init_with(&h->items, sizeof(TYPE), 0, a); \
+	} \
+	\
+	static inline void NAME##_init(NAME##_t *h) { \
+		NAME##_init_with(h, NULL); \
+	} \
+	\
+	static inline void NAME##_free(NAME##_t *h) { \
+		darray_free(&h->items); \
+	} \
+	\
+	static inline int NAME##_push(NAME##_t *h, TYPE value) { \
+		if (darray_add(&h->items, &value) != 0) \
+			return -1; \
+		\
+		NAME##_sift_up(h, h->items.count - 1); \
+		return 0; \
+	} \
+	\
+	static inline int NAME##_pop(NAME##_t *h, TYPE *out) { \
+		if (h->items.count == 0) \
+			return -1; \
+		\
+		TYPE top = NAME##_remove_at(h, 0); \
+		if (out != NULL) \
+			*out = top; \
+		\
+		return 0; \
+	} \
+	\
+	static inline TYPE *NAME##_peek(NAME##_t *h) { \
+		return h->items.count == 0? NULL : (TYPE*)h->items.buf; \
+	} \
+	\
+	static inline void NAME##_heapify(NAME##_t *h) { \
+		if (h->items.count < 2) \
+			return; \
+		\
+		for (size_t i = (h->items.count - 2) / HEAP_ARITY + 1; i -- > 0;) \
+			NAME##_sift_down(h, i); \
+	} \
+	\
+	static inline int NAME##_from_darray(NAME##_t *h, darray_t *d) { \
+		if (d->elem_size != sizeof(TYPE)) \
+			return -1; \
+		\
+		darray_free(&h->items); \
+		h->items = *d; \
+		darray_init_with(d, d->elem_size, 0, d->allocator); \
+		NAME##_heapify(h); \
+		return 0; \
+	}
+
+#define HEAP_DEFINE_INDEXED(NAME, TYPE, LESS) \
+	typedef struct { \
+		size_t handle; \
+		TYPE   value; \
+	} NAME##_node_t; \
+	\
+	typedef struct { \
+		darray_t items, where; \
+	} NAME##_t; \
+	\
+	static inline bool NAME##_node_less(NAME##_node_t a, NAME##_node_t b) { \
+		return LESS(a.value, b.value); \
+	} \
+	\
+	HEAP_DEFINE_COMMON(NAME, NAME##_node_t, NAME##_node_less, HEAP_MOVED_INDEXED) \
+	\
+	static inline void NAME##_init_with(NAME##_t *h, const allocator_t *a) { \
+		darray_init_with(&h->items, sizeof(NAME##_node_t), 0, a); \
+		darray_init_with(&h->where, sizeof(size_t),        0, a); \
+	} \
+	\
+	static inline void NAME##_init(NAME##_t *h) { \
+		NAME##_init_with(h, NULL); \
+	} \
+	\
+	static inline void NAME##_free(NAME##_t *h) { \
+		darray_free(&h->items); \
+		darray_free(&h->where); \
+	} \
+	\
+	static inline bool NAME##_contains(NAME##_t *h, size_t handle) { \
+		return handle < h->where.count && ((size_t*)h->where.buf)[handle] != HEAP_NPOS; \
+	} \
+	\
+	static inline TYPE *NAME##_get(NAME##_t *h, size_t handle) { \
+		if (!NAME##_contains(h, handle)) \
+			return NULL; \
+		\
+		return &((NAME##_node_t*)h->items.buf)[((size_t*)h->where.buf)[handle]].value; \
+	} \
+	\
+	static inline int NAME##_push(NAME##_t *h, size_t handle, TYPE value) { \
+		if (handle == HEAP_NPOS || NAME##_contains(h, handle)) \
+			return -1; \
+		\
+		if (handle >= h->where.count) { \
+			size_t count = h->where.count; \
+			if (darray_resize(&h->where, handle + 1) != 0) \
+				return -1; \
+			\
+			for (; count <= handle; ++ count) \
+				((size_t*)h->where.buf)[count] = HEAP_NPOS; \
+		} \
+		\
+		NAME##_node_t node; \
+		node.handle = handle; \
+		node.value  = value; \
+		if (darray_add(&h->items, &node) != 0) \
+			return -1; \
+		\
+		NAME##_sift_up(h, h->items.count - 1); \
+		return 0; \
+	} \
+	\
+	static inline int NAME##_pop(NAME##_t *h, size_t *handle, TYPE *out) { \
+		if (h->items.count == 0) \
+			return -1; \
+		\
+		NAME##_node_t top = NAME##_remove_at(h, 0); \
+		((size_t*)h->where.buf)[top.handle] = HEAP_NPOS; \
+		if (handle != NULL) \
+			*handle = top.handle; \
+		if (out != NULL) \
+			*out = top.value; \
+		\
+		return 0; \
+	} \
+	\
+	static inline NAME##_node_t *NAME##_peek(NAME##_t *h) { \
+		return h->items.count == 0? NULL : (NAME##_node_t*)h->items.buf; \
+	} \
+	\
+	static inline int NAME##_decrease_key(NAME##_t *h, size_t handle, TYPE value) { \
+		if (!NAME##_contains(h, handle)) \
+			return -1; \
+		\
+		size_t pos = ((size_t*)h->where.buf)[handle]; \
+		((NAME##_node_t*)h->items.buf)[pos].value = value; \
+		NAME##_sift_up(h, pos); \
+		return 0; \
+	} \
+	\
+	static inline int NAME##_update(NAME##_t *h, size_t handle, TYPE value) { \
+		if (!NAME##_contains(h, handle)) \
+			return -1; \
+		\
+		size_t pos = ((size_t*)h->where.buf)[handle]; \
+		((NAME##_node_t*)h->items.buf)[pos].value = value; \
+		NAME##_fix(h, pos); \
+		return 0; \
+	} \
+	\
+	static inline int NAME##_erase(NAME##_t *h, size_t handle) { \
+		if (!NAME##_contains(h, handle)) \
+			return -1; \
+		\
+		NAME##_remove_at(h, ((size_t*)h->where.buf)[handle]); \
+		((size_t*)h->where.buf)[handle] = HEAP_NPOS; \
+		return 0; \
+	}
+
+/*
+ * HEAP_DEFINE(NAME, TYPE, LESS)
+ *     Defines a heap type 'NAME'_t of elements of type 'TYPE', along with its functions. 'LESS' is
+ *     a macro (or function) taking two values of 'TYPE' and returning true if the first one has to
+ *     be popped before the second one, so a "less than" makes a min-heap. It is expanded into the
+ *     functions, so the comparisons are inlined. Example:
+ *         | #define TASK_LESS(A, B) ((A).priority < (B).priority)
+ *         | HEAP_DEFINE(tasks, task_t, TASK_LESS)
+ *
+ *     'NAME'_t
+ *         darray_t items
+ *             The elements in heap order, the first one is the top
+ *
+ *     void 'NAME'_init('NAME'_t *h)
+ *         Initializes 'h' as empty. Does not allocate.
+ *
+ *     void 'NAME'_init_with('NAME'_t *h, const allocator_t *a)
+ *         Same as 'NAME'_init, but 'h' allocates with 'a'.
+ *
+ *     void 'NAME'_free('NAME'_t *h)
+ *         Frees 'h'.
+ *
+ *     int 'NAME'_reserve('NAME'_t *h, size_t size)
+ *         Makes sure 'h' has space for 'size' elements. Returns 0 on success.
+ *
+ *     int 'NAME'_push('NAME'_t *h, TYPE value)
+ *         Adds 'value' to 'h'. Returns 0 on success.
+ *
+ *     int 'NAME'_pop('NAME'_t *h, TYPE *out)
+ *         Removes the top element of 'h' and copies it to 'out', if 'out' is not NULL. Returns -1
+ *         if 'h' is empty.
+ *
+ *     TYPE *'NAME'_peek('NAME'_t *h)
+ *         Returns a pointer to the top element of 'h', or NULL if 'h' is empty.
+ *
+ *     void 'NAME'_heapify('NAME'_t *h)
+ *         Restores the heap order of 'h' in O(n), after the elements in 'items' were changed
+ *         directly.
+ *
+ *     int 'NAME'_from_darray('NAME'_t *h, darray_t *d)
+ *         Frees 'h' and takes over the buffer of 'd' without copying it, then heapifies it in
+ *         O(n). 'd' is left empty. Returns -1 if the element size of 'd' is not sizeof(TYPE).
+ *
+ * HEAP_DEFINE_INDEXED(NAME, TYPE, LESS)
+ *     Same as HEAP_DEFINE, but each element is pushed with a handle: a small integer chosen by the
+ *     caller (like a node or task id). The heap keeps the position of each handle in a handle
+ *     array indexed by the handle, so an element can be found, changed and removed in O(log n).
+ *     The handle array is as large as the largest handle pushed.
+ *
+ *     'NAME'_node_t
+ *         size_t handle
+ *         TYPE value
+ *
+ *     'NAME'_t
+ *         darray_t items
+ *             The nodes in heap order
+ *         darray_t where
+ *             The handle array, the position of each handle in 'items' or HEAP_NPOS
+ *
+ *     int 'NAME'_push('NAME'_t *h, size_t handle, TYPE value)
+ *         Adds 'value' to 'h' with the handle 'handle'. Returns -1 if 'handle' is already in 'h'
+ *         or on allocation fail.
+ *
+ *     int 'NAME'_pop('NAME'_t *h, size_t *handle, TYPE *out)
+ *         Removes the top element of 'h' and copies its handle to 'handle' and value to 'out',
+ *         each if not NULL. Returns -1 if 'h' is empty.
+ *
+ *     'NAME'_node_t *'NAME'_peek('NAME'_t *h)
+ *         Returns a pointer to the top node of 'h', or NULL if 'h' is empty.
+ *
+ *     bool 'NAME'_contains('NAME'_t *h, size_t handle)
+ *         Returns true if 'handle' is in 'h'.
+ *
+ *     TYPE *'NAME'_get('NAME'_t *h, size_t handle)
+ *         Returns a pointer to the value of 'handle', or NULL if it is not in 'h'. Use
+ *         'NAME'_update to change the value.
+ *
+ *     int 'NAME'_decrease_key('NAME'_t *h, size_t handle, TYPE value)
+ *         Sets the value of 'handle' to 'value', which must not be "greater" than the old value
+ *         (according to 'LESS'), and moves it up. Returns -1 if 'handle' is not in 'h'.
+ *
+ *     int 'NAME'_update('NAME'_t *h, size_t handle, TYPE value)
+ *         Same as 'NAME'_decrease_key, but 'value' can be anything.
+ *
+ *     int 'NAME'_erase('NAME'_t *h, size_t handle)
+ *         Removes 'handle' from 'h'. Returns -1 if it is not in 'h'.
+ *
+ *     'NAME'_init, 'NAME'_init_with, 'NAME'_free and 'NAME'_reserve are the same as with
+ *     HEAP_DEFINE.
+ */
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,481 @@
+/*
+ * This library is a part of the C header-only libraries collection
+ * (https://github.com/LordOfTrident/chol)
+ *
+ * This is an STB-style library, so to include the library implementation, you need to define
+ * the implementation macro:
+ *     #define CHOL_MMARRAY_IMPLEMENTATION
+ *
+ * This library provides a file-backed dynamic array. Its buffer is a memory mapped file, so the
+ * array can be larger than RAM (the OS pages it in and out), and reopening the file gives the data
+ * of the previous run back without reading or deserializing anything.
+ */
+
+/* Simple example of the library:
+#include <stdio.h>
+
+#define CHOL_MMARRAY_IMPLEMENTATION
+#include <chol/mmarray.h>
+
+int main(void) {
+	mmarray_t nums;
+	if (MMARRAY_OPEN(&nums, "nums.bin", int) != 0)
+		return 1;
+
+	int num = (int)nums.count;
+	mmarray_add(&nums, &num);
+	printf("this program ran %zu times\n", nums.count);
+
+	mmarray_close(&nums);
+	return 0;
+}
+*/
+
+#ifndef CHOL_MMARRAY_H_HEADER_GUARD
+#define CHOL_MMARRAY_H_HEADER_GUARD
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>  /* size_t */
+#include <string.h>  /* memcpy, memset, memcmp */
+#include <stdint.h>  /* uint64_t, SIZE_MAX */
+
+#include "sys.h"
+
+#define CHOL_MMARRAY_VERSION_MAJOR 1
+#define CHOL_MMARRAY_VERSION_MINOR 0
+#define CHOL_MMARRAY_VERSION_PATCH 2
+
+/*
+ * 1.0.0: Memory mapped file-backed dynamic array
+ * 1.0.1: Fix mremap never being used on Linux
+ * 1.0.2: Fix a failed remap on Windows unmapping the array, reject files of other versions
+ */
+
+#ifndef MMARRAY_CHUNK_SIZE
+#	define MMARRAY_CHUNK_SIZE 1024
+#endif
+
+#ifndef MMARRAY_GROWTH_NUM
+#	define MMARRAY_GROWTH_NUM 2
+#endif
+
+#ifndef MMARRAY_GROWTH_DEN
+#	define MMARRAY_GROWTH_DEN 1
+#endif
+
+#define MMARRAY_MAGIC       "CHOLMMA"
+#define MMARRAY_HEADER_SIZE 64
+
+typedef struct {
+	char     magic[8];
+	uint64_t version, elem_size, count;
+} mmarray_header_t;
+
+typedef struct {
+	void  *buf;
+	size_t count, size, elem_size;
+
+	mmarray_header_t *header;
+	size_t            map_size;
+#ifdef WIN32
+	HANDLE file, mapping;
+#else
+	int fd;
+#endif
+} mmarray_t;
+
+/*
+ * MMARRAY_CHUNK_SIZE
+ *     The capacity of a newly created file in elements. If not defined before including, the
+ *     default is 1024.
+ *
+ * MMARRAY_GROWTH_NUM, MMARRAY_GROWTH_DEN
+ *     The growth factor of the file, same as DARRAY_GROWTH_NUM and DARRAY_GROWTH_DEN. If not
+ *     defined before including, the default is 2 / 1.
+ *
+ * The file starts with a MMARRAY_HEADER_SIZE bytes big header (mmarray_header_t), followed by
+ * the elements. The header is written in the native byte order, so the files are only portable
+ * between machines with the same endianness.
+ *
+ *     mmarray_header_t
+ *         char magic[8]
+ *             MMARRAY_MAGIC
+ *         uint64_t version
+ *             CHOL_MMARRAY_VERSION_MAJOR of the library that created the file
+ *         uint64_t elem_size
+ *             Size of a single element in bytes
+ *         uint64_t count
+ *             Count of elements
+ *
+ *     mmarray_t
+ *         File-backed dynamic array structure
+ *
+ *         void *buf
+ *             The mapped elements. This pointer changes when the array grows.
+ *         size_t count
+ *             Count of elements
+ *         size_t size
+ *             Capacity of the file (in elements)
+ *         size_t elem_size
+ *             Size of a single element in bytes
+ *         mmarray_header_t *header
+ *             The mapped header
+ *         size_t map_size
+ *             Size of the mapping (and the file) in bytes
+ */
+
+#define MMARRAY_OPEN(M, PATH, TYPE) mmarray_open(M, PATH, sizeof(TYPE))
+#define MMARRAY_AT(M, IDX, TYPE)    ((TYPE*)mmarray_at(M, IDX))
+
+/*
+ * MMARRAY_OPEN(M, PATH, TYPE)
+ *     Opens the file 'PATH' into 'M' for the type 'TYPE'. Returns 0 on success.
+ *
+ * MMARRAY_AT(M, IDX, TYPE)
+ *     Returns a pointer to the element in 'M' at 'IDX' of type 'TYPE'.
+ */
+
+int mmarray_open( mmarray_t *m, const char *path, size_t elem_size);
+int mmarray_close(mmarray_t *m);
+int mmarray_sync( mmarray_t *m);
+
+int   mmarray_add(    mmarray_t *m, const void *data);
+int   mmarray_extend( mmarray_t *m, const void *data, size_t n);
+void *mmarray_at(     mmarray_t *m, size_t idx);
+int   mmarray_reserve(mmarray_t *m, size_t size);
+int   mmarray_resize( mmarray_t *m, size_t count);
+
+int mmarray_shrink_to_fit(mmarray_t *m);
+
+/*
+ * The functions that return int return 0 on success and -1 on failure.
+ *
+ * int mmarray_open(mmarray_t *m, const char *path, size_t elem_size)
+ *     Opens the file 'path' into 'm', creating it if it does not exist. If it exists, its header
+ *     has to match CHOL_MMARRAY_VERSION_MAJOR and 'elem_size', and its elements are mapped as
+ *     they are (zero-copy).
+ *
+ * int mmarray_close(mmarray_t *m)
+ *     Unmaps and closes 'm'. The changes are written back to the file by the OS.
+ *
+ * int mmarray_sync(mmarray_t *m)
+ *     Flushes the changes of 'm' to the file and waits for the write to finish.
+ *
+ * int mmarray_add(mmarray_t *m, const void *data)
+ *     Copies data from 'data' into 'm' as a new element (appends).
+ *
+ * int mmarray_extend(mmarray_t *m, const void *data, size_t n)
+ *     Appends 'n' elements from 'data' to 'm', growing the file at most once.
+ *
+ * void *mmarray_at(mmarray_t *m, size_t idx)
+ *     Returns a pointer to the element in 'm' at 'idx', or NULL if 'idx' is out of bounds. The
+ *     pointer is invalidated when 'm' grows.
+ *
+ * int mmarray_reserve(mmarray_t *m, size_t size)
+ *     Grows the file of 'm' to fit at least 'size' elements. The file is extended (ftruncate on
+ *     Unix/Linux) and remapped (with mremap on Linux), the elements are never copied.
+ *
+ * int mmarray_resize(mmarray_t *m, size_t count)
+ *     Sets the count of elements in 'm' to 'count'. New elements are zero initialized.
+ *
+ * int mmarray_shrink_to_fit(mmarray_t *m)
+ *     Truncates the file of 'm' to fit exactly its elements. On failure the elements stay mapped,
+ *     except on Windows if even mapping the file again failed, in which case 'm' is left with
+ *     nothing mapped and can only be closed.
+ */
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+#ifdef CHOL_MMARRAY_IMPLEMENTATION
+#ifndef WIN32
+#	include <fcntl.h>    /* open, O_RDWR, O_CREAT */
+#	include <sys/mman.h> /* mmap, munmap, mremap, msync */
+#	include <sys/stat.h> /* fstat, struct stat */
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* glibc only declares mremap with _GNU_SOURCE defined before the first system header, which is
+   out of the control of this header, so it is declared here when it is missing */
+#if defined(__linux__) && !defined(MREMAP_MAYMOVE)
+#	define MREMAP_MAYMOVE 1
+
+void *mremap(void *old_address, size_t old_size, size_t new_size, int flags, ...);
+#endif
+
+#ifdef WIN32
+/* Maps 'size' bytes of 'file', extending it if it is smaller. Returns NULL on failure */
+static void *mmarray_map_view(HANDLE file, size_t size, HANDLE *mapping) {
+	*mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE,
+	                              (DWORD)((uint64_t)size >> 32), (DWORD)size, NULL);
+	if (*mapping == NULL)
+		return NULL;
+
+	void *map = MapViewOfFile(*mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	if (map == NULL)
+		CloseHandle(*mapping);
+
+	return map;
+}
+#endif
+
+/* Unmaps 'm' and maps its file again with 'size' bytes, extending or truncating the file */
+static int mmarray_map(mmarray_t *m, size_t size) {
+#ifdef WIN32
+	HANDLE mapping;
+	void  *map;
+	if (m->header == NULL || size >= m->map_size) {
+		/* A file mapping extends the file, so the new view is created before the old one is
+		   unmapped, which keeps the old one valid on failure */
+		map = mmarray_map_view(m->file, size, &mapping);
+		if (map == NULL)
+			return -1;
+
+		if (m->header != NULL) {
+			UnmapViewOfFile(m->header);
+			CloseHandle(m->mapping);
+		}
+	} else {
+		/* A mapped file cannot be truncated, so the old view has to be unmapped first. If the
+		   truncation fails, the old size is mapped again */
+		UnmapViewOfFile(m->header);
+		CloseHandle(m->mapping);
+
+		LARGE_INTEGER file_size;
+		file_size.QuadPart = (LONGLONG)size;
+		BOOL truncated = SetFilePointerEx(m->file, file_size, NULL, FILE_BEGIN) &&
+		                 SetEndOfFile(m->file);
+
+		map = mmarray_map_view(m->file, truncated? size : m->map_size, &mapping);
+		if (map == NULL) {
+			m->header   = NULL;
+			m->buf      = NULL;
+			m->map_size = 0;
+			m->size     = 0;
+			m->count    = 0;
+			return -1;
+		}
+
+		if (!truncated) {
+			m->mapping = mapping;
+			m->header  = (mmarray_header_t*)map;
+			m->buf     = (char*)map + MMARRAY_HEADER_SIZE;
+			return -1;
+		}
+	}
+
+	m->mapping = mapping;
+#else
+	if (ftruncate(m->fd, (off_t)size) != 0)
+		return -1;
+
+	/* On failure the old mapping stays valid. The file might stay extended, which only adds
+	   unused capacity. */
+	void *map;
+#	ifdef MREMAP_MAYMOVE
+	if (m->header != NULL)
+		map = mremap(m->header, m->map_size, size, MREMAP_MAYMOVE);
+	else
+		map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, m->fd, 0);
+#	else
+	map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, m->fd, 0);
+	if (map != MAP_FAILED && m->header != NULL)
+		munmap(m->header, m->map_size);
+#	endif
+
+	if (map == MAP_FAILED)
+		return -1;
+#endif
+
+	m->header   = (mmarray_header_t*)map;
+	m->buf      = (char*)map + MMARRAY_HEADER_SIZE;
+	m->map_size = size;
+	m->size     = (size - MMARRAY_HEADER_SIZE) / m->elem_size;
+	return 0;
+}
+
+static int mmarray_remap(mmarray_t *m, size_t size) {
+	if (size > (SIZE_MAX - MMARRAY_HEADER_SIZE) / m->elem_size)
+		return -1;
+
+	return mmarray_map(m, MMARRAY_HEADER_SIZE + size * m->elem_size);
+}
+
+static void mmarray_close_file(mmarray_t *m) {
+#ifdef WIN32
+	CloseHandle(m->file);
+#else
+	close(m->fd);
+#endif
+}
+
+int mmarray_open(mmarray_t *m, const char *path, size_t elem_size) {
+	memset(m, 0, sizeof(*m));
+	m->elem_size = elem_size;
+
+	size_t file_size;
+#ifdef WIN32
+	m->file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS,
+	                      FILE_ATTRIBUTE_NORMAL, NULL);
+	if (m->file == INVALID_HANDLE_VALUE)
+		return -1;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m->file, &size)) {
+		CloseHandle(m->file);
+		return -1;
+	}
+
+	file_size = (size_t)size.QuadPart;
+#else
+	m->fd = open(path, O_RDWR | O_CREAT, 0644);
+	if (m->fd < 0)
+		return -1;
+
+	struct stat st;
+	if (fstat(m->fd, &st) != 0) {
+		close(m->fd);
+		return -1;
+	}
+
+	file_size = (size_t)st.st_size;
+#endif
+
+	/* A new file, create the header */
+	if (file_size == 0) {
+		if (mmarray_remap(m, MMARRAY_CHUNK_SIZE) != 0) {
+			mmarray_close_file(m);
+			return -1;
+		}
+
+		memset(m->header, 0, MMARRAY_HEADER_SIZE);
+		memcpy(m->header->magic, MMARRAY_MAGIC, sizeof(MMARRAY_MAGIC));
+		m->header->version   = CHOL_MMARRAY_VERSION_MAJOR;
+		m->header->elem_size = elem_size;
+		m->header->count     = 0;
+		return 0;
+	}
+
+	if (file_size < MMARRAY_HEADER_SIZE || mmarray_map(m, file_size) != 0) {
+		mmarray_close_file(m);
+		return -1;
+	}
+
+	/* Files of another major version might have a different layout */
+	if (memcmp(m->header->magic, MMARRAY_MAGIC, sizeof(MMARRAY_MAGIC)) != 0 ||
+	    m->header->version != CHOL_MMARRAY_VERSION_MAJOR ||
+	    m->header->elem_size != elem_size || m->header->count > m->size) {
+		mmarray_close(m);
+		return -1;
+	}
+
+	m->count = (size_t)m->header->count;
+	return 0;
+}
+
+int mmarray_close(mmarray_t *m) {
+	int ret = 0;
+	if (m->header != NULL) {
+#ifdef WIN32
+		if (!UnmapViewOfFile(m->header))
+			ret = -1;
+
+		CloseHandle(m->mapping);
+#else
+		if (munmap(m->header, m->map_size) != 0)
+			ret = -1;
+#endif
+	}
+
+	mmarray_close_file(m);
+	memset(m, 0, sizeof(*m));
+	return ret;
+}
+
+int mmarray_sync(mmarray_t *m) {
+#ifdef WIN32
+	return FlushViewOfFile(m->header, 0) && FlushFileBuffers(m->file)? 0 : -1;
+#else
+	return msync(m->header, m->map_size, MS_SYNC);
+#endif
+}
+
+/* Grows 'm' to fit at least 'needed' elements by the growth factor */
+static int mmarray_grow(mmarray_t *m, size_t needed) {
+	size_t size = m->size > SIZE_MAX / MMARRAY_GROWTH_NUM?
+	              SIZE_MAX : m->size * MMARRAY_GROWTH_NUM / MMARRAY_GROWTH_DEN;
+	if (size < needed)
+		size = needed;
+
+	return mmarray_remap(m, size);
+}
+
+static void mmarray_set_count(mmarray_t *m, size_t count) {
+	m->count         = count;
+	m->header->count = count;
+}
+
+int mmarray_add(mmarray_t *m, const void *data) {
+	return mmarray_extend(m, data, 1);
+}
+
+int mmarray_extend(mmarray_t *m, const void *data, size_t n) {
+	if (n > SIZE_MAX - m->count)
+		return -1;
+
+	if (m->count + n > m->size) {
+		if (mmarray_grow(m, m->count + n) != 0)
+			return -1;
+	}
+
+	memcpy((char*)m->buf + m->count * m->elem_size, data, n * m->elem_size);
+	mmarray_set_count(m, m->count + n);
+	return 0;
+}
+
+void *mmarray_at(mmarray_t *m, size_t idx) {
+	if (idx >= m->count)
+		return NULL;
+
+	return (char*)m->buf + idx * m->elem_size;
+}
+
+int mmarray_reserve(mmarray_t *m, size_t size) {
+	if (size <= m->size)
+		return 0;
+
+	return mmarray_remap(m, size);
+}
+
+int mmarray_resize(mmarray_t *m, size_t count) {
+	if (count > m->size) {
+		if (mmarray_grow(m, count) != 0)
+			return -1;
+	}
+
+	/* The file might contain old elements past the count, so clear them */
+	if (count > m->count)
+		memset((char*)m->buf + m->count * m->elem_size, 0, (count - m->count) * m->elem_size);
+
+	mmarray_set_count(m, count);
+	return 0;
+}
+
+int mmarray_shrink_to_fit(mmarray_t *m) {
+	if (m->count == m->size)
+		return 0;
+
+	return mmarray_remap(m, m->count);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
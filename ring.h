@@ -0,0 +1,354 @@
+/*
+ * This library is a part of the C header-only libraries collection
+ * (https://github.com/LordOfTrident/chol)
+ *
+ * This is an STB-style library, so to include the library implementation, you need to define
+ * the implementation macro:
+ *     #define CHOL_RING_IMPLEMENTATION
+ *
+ * This library provides a ring buffer (double-ended queue) with O(1) push and pop at both ends.
+ * It either grows like darray_t or has a fixed capacity.
+ */
+
+/* Simple example of the library:
+#include <stdio.h>
+
+#define CHOL_RING_IMPLEMENTATION
+#include <chol/ring.h>
+
+int main(void) {
+	ring_t queue;
+	RING_INIT(&queue, int);
+
+	for (int i = 0; i < 10; ++ i)
+		ring_push_back(&queue, &i);
+
+	int num;
+	while (ring_pop_front(&queue, &num) == 0)
+		printf("%i\n", num);
+
+	ring_free(&queue);
+	return 0;
+}
+*/
+
+#ifndef CHOL_RING_H_HEADER_GUARD
+#define CHOL_RING_H_HEADER_GUARD
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>  /* size_t */
+#include <string.h>  /* memcpy */
+#include <stdint.h>  /* SIZE_MAX */
+#include <stdbool.h> /* bool, true, false */
+
+#include "alloc.h"
+
+#define CHOL_RING_VERSION_MAJOR 1
+#define CHOL_RING_VERSION_MINOR 0
+#define CHOL_RING_VERSION_PATCH 0
+
+/*
+ * 1.0.0: Growable and fixed capacity ring buffer
+ */
+
+#ifndef RING_CHUNK_SIZE
+#	define RING_CHUNK_SIZE 32
+#endif
+
+typedef struct {
+	void  *buf;
+	size_t head, count, size, elem_size;
+	bool   fixed;
+
+	const allocator_t *allocator;
+} ring_t;
+
+/*
+ * RING_CHUNK_SIZE
+ *     The size of the first allocation of a growable ring buffer in elements. Has to be a power of
+ *     2. If not defined before including, the default is 32.
+ *
+ *     ring_t
+ *         Ring buffer structure. The capacity is always a power of 2, so an index wraps around with
+ *         a mask instead of a division. A growable ring buffer doubles its capacity when full.
+ *
+ *         void *buf
+ *             The raw buffer
+ *         size_t head
+ *             Index of the first element in the buffer
+ *         size_t count
+ *             Count of elements
+ *         size_t size
+ *             Capacity of the buffer (in elements)
+ *         size_t elem_size
+ *             Size of a single element in bytes
+ *         bool fixed
+ *             True if the capacity is fixed
+ *         const allocator_t *allocator
+ *             The allocator of the buffer, NULL for libc (see alloc.h)
+ */
+
+#define RING_INIT(R, TYPE)             ring_init(R, sizeof(TYPE))
+#define RING_INIT_FIXED(R, TYPE, SIZE) ring_init_fixed(R, sizeof(TYPE), SIZE)
+#define RING_AT(R, IDX, TYPE)          ((TYPE*)ring_at(R, IDX))
+
+/*
+ * RING_INIT(R, TYPE)
+ *     Initializes 'R' as growable for the type 'TYPE'.
+ *
+ * RING_INIT_FIXED(R, TYPE, SIZE)
+ *     Initializes 'R' with the fixed capacity 'SIZE' for the type 'TYPE'. Returns 0 on success.
+ *
+ * RING_AT(R, IDX, TYPE)
+ *     Returns a pointer to the element in 'R' at 'IDX' of type 'TYPE'.
+ */
+
+void ring_init(      ring_t *r, size_t elem_size);
+int  ring_init_fixed(ring_t *r, size_t elem_size, size_t size);
+void ring_init_with( ring_t *r, size_t elem_size, const allocator_t *a);
+void ring_free(      ring_t *r);
+int  ring_reserve(   ring_t *r, size_t size);
+void ring_clear(     ring_t *r);
+
+int ring_push_back( ring_t *r, const void *data);
+int ring_push_front(ring_t *r, const void *data);
+int ring_pop_back(  ring_t *r, void *out);
+int ring_pop_front( ring_t *r, void *out);
+
+int ring_push_back_n(ring_t *r, const void *data, size_t n);
+int ring_pop_front_n(ring_t *r, void *out, size_t n);
+
+void *ring_at(   ring_t *r, size_t idx);
+void *ring_front(ring_t *r);
+void *ring_back( ring_t *r);
+
+/*
+ * The functions that return int return 0 on success and -1 on failure (an allocation fail, a
+ * full fixed ring buffer or not enough elements to pop), in which case 'r' is left unchanged.
+ *
+ * void ring_init(ring_t *r, size_t elem_size)
+ *     Initializes 'r' as an empty growable ring buffer. Does not allocate.
+ *
+ * int ring_init_fixed(ring_t *r, size_t elem_size, size_t size)
+ *     Initializes 'r' as an empty ring buffer with the fixed capacity 'size', which has to be a
+ *     power of 2. The buffer is allocated right away and never reallocated.
+ *
+ * void ring_init_with(ring_t *r, size_t elem_size, const allocator_t *a)
+ *     Same as ring_init, but 'r' allocates with 'a'. To make a fixed ring buffer with a custom
+ *     allocator, set 'fixed' to true after ring_reserve.
+ *
+ * void ring_free(ring_t *r)
+ *     Frees 'r'.
+ *
+ * int ring_reserve(ring_t *r, size_t size)
+ *     Makes sure 'r' has space for at least 'size' elements (rounded up to a power of 2).
+ *
+ * void ring_clear(ring_t *r)
+ *     Removes all the elements of 'r'.
+ *
+ * int ring_push_back(ring_t *r, const void *data)
+ * int ring_push_front(ring_t *r, const void *data)
+ *     Copies data from 'data' into 'r' as a new last/first element.
+ *
+ * int ring_pop_back(ring_t *r, void *out)
+ * int ring_pop_front(ring_t *r, void *out)
+ *     Removes the last/first element of 'r' and copies it to 'out', if 'out' is not NULL.
+ *
+ * int ring_push_back_n(ring_t *r, const void *data, size_t n)
+ *     Appends 'n' elements from 'data' to 'r'. The elements are copied with at most two memcpy
+ *     calls (one if the free space does not wrap around), growing 'r' at most once.
+ *
+ * int ring_pop_front_n(ring_t *r, void *out, size_t n)
+ *     Removes 'n' elements from the front of 'r' and copies them to 'out' (if not NULL) with at
+ *     most two memcpy calls.
+ *
+ * void *ring_at(ring_t *r, size_t idx)
+ *     Returns a pointer to the element 'idx' counted from the front of 'r', or NULL if 'idx' is out
+ *     of bounds.
+ *
+ * void *ring_front(ring_t *r)
+ * void *ring_back(ring_t *r)
+ *     Returns a pointer to the first/last element of 'r', or NULL if 'r' is empty.
+ */
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+#ifdef CHOL_RING_IMPLEMENTATION
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static char *ring_slot(ring_t *r, size_t idx) {
+	return (char*)r->buf + ((r->head + idx) & (r->size - 1)) * r->elem_size;
+}
+
+/* Copies 'n' elements from 'data' into the buffer starting at the index 'idx' from the head */
+static void ring_copy_in(ring_t *r, size_t idx, const void *data, size_t n) {
+	size_t start = (r->head + idx) & (r->size - 1);
+	size_t first = r->size - start;
+	if (first > n)
+		first = n;
+
+	memcpy((char*)r->buf + start * r->elem_size, data, first * r->elem_size);
+	if (first < n)
+		memcpy(r->buf, (const char*)data + first * r->elem_size, (n - first) * r->elem_size);
+}
+
+/* Copies 'n' elements starting at the index 'idx' from the head out into 'out' */
+static void ring_copy_out(ring_t *r, size_t idx, void *out, size_t n) {
+	size_t start = (r->head + idx) & (r->size - 1);
+	size_t first = r->size - start;
+	if (first > n)
+		first = n;
+
+	memcpy(out, (char*)r->buf + start * r->elem_size, first * r->elem_size);
+	if (first < n)
+		memcpy((char*)out + first * r->elem_size, r->buf, (n - first) * r->elem_size);
+}
+
+void ring_init(ring_t *r, size_t elem_size) {
+	ring_init_with(r, elem_size, NULL);
+}
+
+/* Moves the elements into a new buffer of 'size' elements, unwrapping them to its start */
+static int ring_realloc(ring_t *r, size_t size) {
+	if (size > SIZE_MAX / r->elem_size)
+		return -1;
+
+	void *buf = allocator_alloc(r->allocator, size * r->elem_size);
+	if (buf == NULL)
+		return -1;
+
+	if (r->count > 0)
+		ring_copy_out(r, 0, buf, r->count);
+
+	allocator_free(r->allocator, r->buf);
+	r->buf  = buf;
+	r->head = 0;
+	r->size = size;
+	return 0;
+}
+
+int ring_init_fixed(ring_t *r, size_t elem_size, size_t size) {
+	ring_init(r, elem_size);
+	if (size == 0 || (size & (size - 1)) != 0 || ring_realloc(r, size) != 0)
+		return -1;
+
+	r->fixed = true;
+	return 0;
+}
+
+void ring_init_with(ring_t *r, size_t elem_size, const allocator_t *a) {
+	r->buf       = NULL;
+	r->head      = 0;
+	r->count     = 0;
+	r->size      = 0;
+	r->elem_size = elem_size;
+	r->fixed     = false;
+	r->allocator = a;
+}
+
+void ring_free(ring_t *r) {
+	allocator_free(r->allocator, r->buf);
+	ring_init_with(r, r->elem_size, r->allocator);
+}
+
+int ring_reserve(ring_t *r, size_t size) {
+	if (size <= r->size)
+		return 0;
+
+	if (r->fixed)
+		return -1;
+
+	size_t new_size = r->size == 0? RING_CHUNK_SIZE : r->size;
+	while (new_size < size) {
+		if (new_size > SIZE_MAX / 2)
+			return -1;
+
+		new_size *= 2;
+	}
+
+	return ring_realloc(r, new_size);
+}
+
+void ring_clear(ring_t *r) {
+	r->head  = 0;
+	r->count = 0;
+}
+
+int ring_push_back(ring_t *r, const void *data) {
+	return ring_push_back_n(r, data, 1);
+}
+
+int ring_push_front(ring_t *r, const void *data) {
+	if (r->count == SIZE_MAX || ring_reserve(r, r->count + 1) != 0)
+		return -1;
+
+	r->head = (r->head - 1) & (r->size - 1);
+	memcpy((char*)r->buf + r->head * r->elem_size, data, r->elem_size);
+	++ r->count;
+	return 0;
+}
+
+int ring_pop_back(ring_t *r, void *out) {
+	if (r->count == 0)
+		return -1;
+
+	-- r->count;
+	if (out != NULL)
+		memcpy(out, ring_slot(r, r->count), r->elem_size);
+
+	return 0;
+}
+
+int ring_pop_front(ring_t *r, void *out) {
+	return ring_pop_front_n(r, out, 1);
+}
+
+int ring_push_back_n(ring_t *r, const void *data, size_t n) {
+	if (n > SIZE_MAX - r->count || ring_reserve(r, r->count + n) != 0)
+		return -1;
+
+	if (n > 0)
+		ring_copy_in(r, r->count, data, n);
+
+	r->count += n;
+	return 0;
+}
+
+int ring_pop_front_n(ring_t *r, void *out, size_t n) {
+	if (n > r->count)
+		return -1;
+
+	if (n == 0)
+		return 0;
+
+	if (out != NULL)
+		ring_copy_out(r, 0, out, n);
+
+	r->head   = (r->head + n) & (r->size - 1);
+	r->count -= n;
+	return 0;
+}
+
+void *ring_at(ring_t *r, size_t idx) {
+	return idx < r->count? ring_slot(r, idx) : NULL;
+}
+
+void *ring_front(ring_t *r) {
+	return ring_at(r, 0);
+}
+
+void *ring_back(ring_t *r) {
+	return r->count == 0? NULL : ring_slot(r, r->count - 1);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,283 @@
+/*
+ * This library is a part of the C header-only libraries collection
+ * (https://github.com/LordOfTrident/chol)
+ *
+ * This is an STB-style library, so to include the library implementation, you need to define
+ * the implementation macro:
+ *     #define CHOL_SEGARRAY_IMPLEMENTATION
+ *
+ * This library provides a pointer-stable segmented array. Unlike darray_t, it never moves its
+ * elements: it grows by allocating a new block twice the size of the previous one, so pointers
+ * to the elements stay valid until the array is freed.
+ */
+
+/* Simple example of the library:
+#include <stdio.h>
+
+#define CHOL_SEGARRAY_IMPLEMENTATION
+#include <chol/segarray.h>
+
+int main(void) {
+	segarray_t nums;
+	SEGARRAY_INIT(&nums, int);
+
+	int  num   = 5;
+	int *first = SEGARRAY_ADD(&nums, &num, int);
+	for (num = 0; num < 1000; ++ num)
+		SEGARRAY_ADD(&nums, &num, int);
+
+	printf("%i\n", *first); // still valid
+	SEGARRAY_FREE(&nums);
+	return 0;
+}
+*/
+
+#ifndef CHOL_SEGARRAY_H_HEADER_GUARD
+#define CHOL_SEGARRAY_H_HEADER_GUARD
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>  /* size_t */
+#include <string.h>  /* memcpy */
+#include <stdint.h>  /* SIZE_MAX */
+
+#include "alloc.h"
+
+#define CHOL_SEGARRAY_VERSION_MAJOR 1
+#define CHOL_SEGARRAY_VERSION_MINOR 0
+#define CHOL_SEGARRAY_VERSION_PATCH 0
+
+/*
+ * 1.0.0: Segmented array with geometric block sizes
+ */
+
+#ifndef SEGARRAY_FIRST_SHIFT
+#	define SEGARRAY_FIRST_SHIFT 5
+#endif
+
+#define SEGARRAY_FIRST_SIZE ((size_t)1 << SEGARRAY_FIRST_SHIFT)
+#define SEGARRAY_MAX_BLOCKS (sizeof(size_t) * 8 - SEGARRAY_FIRST_SHIFT)
+
+typedef struct {
+	void  *blocks[sizeof(size_t) * 8];
+	size_t blocks_count, count, elem_size;
+
+	const allocator_t *allocator;
+} segarray_t;
+
+/*
+ * SEGARRAY_FIRST_SHIFT
+ *     The size of the first block is 2 to the power of SEGARRAY_FIRST_SHIFT elements, each next
+ *     block is twice the size of the previous one. If not defined before including, the default
+ *     is 5 (32 elements).
+ *
+ *     segarray_t
+ *         Segmented array structure. Block 'k' holds the elements from
+ *         SEGARRAY_FIRST_SIZE * (2^k - 1) up to SEGARRAY_FIRST_SIZE * (2^(k + 1) - 1), so an index
+ *         is turned into a block and an offset with a single bit scan.
+ *
+ *         void *blocks[]
+ *             The allocated blocks
+ *         size_t blocks_count
+ *             Count of allocated blocks
+ *         size_t count
+ *             Count of elements
+ *         size_t elem_size
+ *             Size of a single element in bytes
+ *         const allocator_t *allocator
+ *             The allocator of the blocks, NULL for libc (see alloc.h)
+ */
+
+#define SEGARRAY_INIT(S, TYPE)      segarray_init(S, sizeof(TYPE))
+#define SEGARRAY_FREE(S)            segarray_free(S)
+#define SEGARRAY_ADD(S, DATA, TYPE) ((TYPE*)segarray_add(S, DATA))
+#define SEGARRAY_AT(S, IDX, TYPE)   ((TYPE*)segarray_at(S, IDX))
+
+#define FOREACH_IN_SEGARRAY(S, TYPE, VAR, BODY) \
+	do { \
+		for (size_t _k = 0, _i = 0; _i < (S)->count; ++ _k) { \
+			TYPE  *_block = (TYPE*)(S)->blocks[_k]; \
+			size_t _n     = SEGARRAY_FIRST_SIZE << _k; \
+			for (size_t _j = 0; _j < _n && _i < (S)->count; ++ _j, ++ _i) { \
+				TYPE *VAR = &_block[_j]; \
+				BODY \
+			} \
+		} \
+	} while (0)
+
+/*
+ * SEGARRAY_INIT(S, TYPE)
+ *     Initializes 'S' for the type 'TYPE'.
+ *
+ * SEGARRAY_FREE(S)
+ *     Frees 'S'.
+ *
+ * SEGARRAY_ADD(S, DATA, TYPE)
+ *     Calls segarray_add and casts the result to pointer to 'TYPE'.
+ *
+ * SEGARRAY_AT(S, IDX, TYPE)
+ *     Returns a pointer to the element in 'S' at 'IDX' of type 'TYPE'.
+ *
+ * FOREACH_IN_SEGARRAY(S, TYPE, VAR, BODY)
+ *     Loops through each element in 'S' block by block, without computing the block of each
+ *     index. 'VAR' is the name of the element pointer variable, which is of type pointer to 'TYPE'
+ *     and 'BODY' is the code to run on each iteration.
+ */
+
+void segarray_init(     segarray_t *s, size_t elem_size);
+void segarray_init_with(segarray_t *s, size_t elem_size, const allocator_t *a);
+void segarray_free(     segarray_t *s);
+
+void *segarray_add(    segarray_t *s, const void *data);
+void *segarray_at(     segarray_t *s, size_t idx);
+int   segarray_reserve(segarray_t *s, size_t count);
+void  segarray_pop(    segarray_t *s);
+
+/*
+ * void segarray_init(segarray_t *s, size_t elem_size)
+ *     Initializes 's' as empty. Does not allocate.
+ *
+ * void segarray_init_with(segarray_t *s, size_t elem_size, const allocator_t *a)
+ *     Same as segarray_init, but 's' allocates with 'a'.
+ *
+ * void segarray_free(segarray_t *s)
+ *     Frees 's'. This invalidates all pointers to its elements.
+ *
+ * void *segarray_add(segarray_t *s, const void *data)
+ *     Copies the data from 'data' into 's' as a new element (appends) and returns a pointer to
+ *     it. Growing never copies the existing elements, so the pointers returned before stay
+ *     valid. Returns NULL on allocation fail.
+ *
+ * void *segarray_at(segarray_t *s, size_t idx)
+ *     Returns a pointer to the element in 's' at 'idx', or NULL if 'idx' is out of bounds.
+ *
+ * int segarray_reserve(segarray_t *s, size_t count)
+ *     Allocates the blocks needed to hold 'count' elements. Returns 0 on success.
+ *
+ * void segarray_pop(segarray_t *s)
+ *     Removes the last element of 's'. The blocks are kept for reuse.
+ */
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+#ifdef CHOL_SEGARRAY_IMPLEMENTATION
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#	include <intrin.h> /* _BitScanReverse, _BitScanReverse64 */
+#endif
+
+/* Returns the index of the highest set bit of 'x', which must not be 0 */
+static size_t segarray_log2(size_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+	return sizeof(unsigned long long) * 8 - 1 - (size_t)__builtin_clzll((unsigned long long)x);
+#elif defined(_MSC_VER) && defined(_WIN64)
+	unsigned long idx;
+	_BitScanReverse64(&idx, x);
+	return idx;
+#elif defined(_MSC_VER)
+	unsigned long idx;
+	_BitScanReverse(&idx, x);
+	return idx;
+#else
+	size_t idx = 0;
+	while (x >>= 1)
+		++ idx;
+
+	return idx;
+#endif
+}
+
+/* Splits the index 'idx' into the block and the offset in it */
+static size_t segarray_locate(size_t idx, size_t *offset) {
+	size_t i     = idx + SEGARRAY_FIRST_SIZE;
+	size_t block = segarray_log2(i) - SEGARRAY_FIRST_SHIFT;
+
+	*offset = i - (SEGARRAY_FIRST_SIZE << block);
+	return block;
+}
+
+void segarray_init(segarray_t *s, size_t elem_size) {
+	segarray_init_with(s, elem_size, NULL);
+}
+
+void segarray_init_with(segarray_t *s, size_t elem_size, const allocator_t *a) {
+	s->blocks_count = 0;
+	s->count        = 0;
+	s->elem_size    = elem_size;
+	s->allocator    = a;
+}
+
+void segarray_free(segarray_t *s) {
+	for (size_t i = 0; i < s->blocks_count; ++ i)
+		allocator_free(s->allocator, s->blocks[i]);
+
+	segarray_init_with(s, s->elem_size, s->allocator);
+}
+
+/* Allocates the next block */
+static int segarray_grow(segarray_t *s) {
+	if (s->blocks_count >= SEGARRAY_MAX_BLOCKS)
+		return -1;
+
+	size_t size = SEGARRAY_FIRST_SIZE << s->blocks_count;
+	if (size > SIZE_MAX / s->elem_size)
+		return -1;
+
+	void *block = allocator_alloc(s->allocator, size * s->elem_size);
+	if (block == NULL)
+		return -1;
+
+	s->blocks[s->blocks_count ++] = block;
+	return 0;
+}
+
+void *segarray_add(segarray_t *s, const void *data) {
+	size_t offset, block = segarray_locate(s->count, &offset);
+	if (block >= s->blocks_count) {
+		if (segarray_grow(s) != 0)
+			return NULL;
+	}
+
+	void *elem = (char*)s->blocks[block] + offset * s->elem_size;
+	memcpy(elem, data, s->elem_size);
+	++ s->count;
+	return elem;
+}
+
+void *segarray_at(segarray_t *s, size_t idx) {
+	if (idx >= s->count)
+		return NULL;
+
+	size_t offset, block = segarray_locate(idx, &offset);
+	return (char*)s->blocks[block] + offset * s->elem_size;
+}
+
+int segarray_reserve(segarray_t *s, size_t count) {
+	if (count == 0)
+		return 0;
+
+	size_t offset, block = segarray_locate(count - 1, &offset);
+	while (block >= s->blocks_count) {
+		if (segarray_grow(s) != 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+void segarray_pop(segarray_t *s) {
+	if (s->count > 0)
+		-- s->count;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
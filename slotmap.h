@@ -0,0 +1,294 @@
+/*
+ * This library is a part of the C header-only libraries collection
+ * (https://github.com/LordOfTrident/chol)
+ *
+ * This library has no implementation section, the slot maps are generated with a macro into
+ * static inline functions. They are built on darray_t though, so the implementation of darray.h
+ * has to be included in one of the files:
+ *     #define CHOL_DARRAY_IMPLEMENTATION
+ *
+ * This library provides a generational slot map. Elements are referred to by handles that stay
+ * valid when other elements are removed, insert, remove and lookup are O(1), and the elements are
+ * kept packed in a single array, so iterating them is as fast as iterating a darray_t.
+ */
+
+/* Simple example of the library:
+#include <stdio.h>
+
+#define CHOL_DARRAY_IMPLEMENTATION
+#include <chol/slotmap.h>
+
+SLOTMAP_DEFINE(names, const char*)
+
+int main(void) {
+	names_t m;
+	names_init(&m);
+
+	slotmap_handle_t foo, bar;
+	names_add(&m, "foo", &foo);
+	names_add(&m, "bar", &bar);
+	names_remove(&m, foo);
+
+	printf("%s\n", *names_get(&m, bar));
+	printf("%p\n", (void*)names_get(&m, foo)); // NULL, the handle is stale
+
+	names_free(&m);
+	return 0;
+}
+*/
+
+#ifndef CHOL_SLOTMAP_H_HEADER_GUARD
+#define CHOL_SLOTMAP_H_HEADER_GUARD
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>  /* size_t */
+#include <stdint.h>  /* uint32_t */
+#include <stdbool.h> /* bool, true, false */
+
+#include "alloc.h"
+#include "darray.h"
+
+#define CHOL_SLOTMAP_VERSION_MAJOR 1
+#define CHOL_SLOTMAP_VERSION_MINOR 0
+#define CHOL_SLOTMAP_VERSION_PATCH 0
+
+/*
+ * 1.0.0: Generational slot map with dense storage over darray_t
+ */
+
+#define SLOTMAP_NONE ((uint32_t)-1)
+
+typedef struct {
+	uint32_t idx, gen;
+} slotmap_handle_t;
+
+typedef struct {
+	uint32_t idx, gen;
+} slotmap_slot_t;
+
+/*
+ * SLOTMAP_NONE
+ *     Index that is never used by a slot.
+ *
+ * slotmap_handle_t
+ *     Handle of an element
+ *
+ *     uint32_t idx
+ *         Index of the slot of the element
+ *     uint32_t gen
+ *         Generation of the slot when the element was added. It is always odd, so a zeroed handle
+ *         is never valid.
+ *
+ * slotmap_slot_t
+ *     Slot of the sparse index
+ *
+ *     uint32_t idx
+ *         Index of the element in the dense array if the slot is used, otherwise the next free
+ *         slot
+ *     uint32_t gen
+ *         Generation of the slot, incremented each time an element is added to or removed from
+ *         it, so it is odd while the slot is used
+ */
+
+#define FOREACH_IN_SLOTMAP(M, TYPE, VAR, BODY) \
+	FOREACH_IN_DARRAY_UNCHECKED(&(M)->values, TYPE, VAR, BODY)
+
+/*
+ * FOREACH_IN_SLOTMAP(M, TYPE, VAR, BODY)
+ *     Loops through each element in the slot map 'M' in the dense order. 'VAR' is the name of the
+ *     element pointer variable, which is of type pointer to 'TYPE' and 'BODY' is the code to run
+ *     on each iteration. 'BODY' must not add or remove elements.
+ */
+
+#define SLOTMAP_DEFINE(NAME, TYPE) \
+	typedef struct { \
+		darray_t values, owners, slots; \
+		uint32_t free_head; \
+	} NAME##_t; \
+	\
+	static inline void NAME##_init_with(NAME##_t *m, const allocator_t *a) { \
+		darray_init_with(&m->values, sizeof(TYPE),           0, a); \
+		darray_init_with(&m->owners, sizeof(uint32_t),       0, a); \
+		darray_init_with(&m->slots,  sizeof(slotmap_slot_t), 0, a); \
+		m->free_head = SLOTMAP_NONE; \
+	} \
+	\
+	static inline void NAME##_init(NAME##_t *m) { \
+		NAME##_init_with(m, NULL); \
+	} \
+	\
+	static inline void NAME##_free(NAME##_t *m) { \
+		darray_free(&m->values); \
+		darray_free(&m->owners); \
+		darray_free(&m->slots); \
+		m->free_head = SLOTMAP_NONE; \
+	} \
+	\
+	static inline int NAME##_reserve(NAME##_t *m, size_t count) { \
+		if (darray_reserve(&m->values, count) != 0 || darray_reserve(&m->owners, count) != 0) \
+			return -1; \
+		\
+		return darray_reserve(&m->slots, count); \
+	} \
+	\
+	static inline bool NAME##_contains(NAME##_t *m, slotmap_handle_t h) { \
+		return (h.gen & 1) != 0 && h.idx < m->slots.count && \
+		       ((slotmap_slot_t*)m->slots.buf)[h.idx].gen == h.gen; \
+	} \
+	\
+	static inline TYPE *NAME##_get(NAME##_t *m, slotmap_handle_t h) { \
+		if (!NAME##_contains(m, h)) \
+			return NULL; \
+		\
+		return &((TYPE*)m->values.buf)[((slotmap_slot_t*)m->slots.buf)[h.idx].idx]; \
+	} \
+	\
+	static inline int NAME##_add(NAME##_t *m, TYPE value, slotmap_handle_t *out) { \
+		uint32_t owner = 0; \
+		if (darray_add(&m->values, &value) != 0) \
+			return -1; \
+		if (darray_add(&m->owners, &owner) != 0) { \
+			-- m->values.count; \
+			return -1; \
+		} \
+		\
+		if (m->free_head != SLOTMAP_NONE) { \
+			owner        = m->free_head; \
+			m->free_head = ((slotmap_slot_t*)m->slots.buf)[owner].idx; \
+		} else { \
+			slotmap_slot_t slot = {0, 0}; \
+			if (m->slots.count >= SLOTMAP_NONE || darray_add(&m->slots, &slot) != 0) { \
+				-- m->values.count; \
+				-- m->owners.count; \
+				return -1; \
+			} \
+			\
+			owner = (uint32_t)(m->slots.count - 1); \
+		} \
+		\
+		slotmap_slot_t *slot = &((slotmap_slot_t*)m->slots.buf)[owner]; \
+		slot->idx = (uint32_t)(m->values.count - 1); \
+		++ slot->gen; \
+		((uint32_t*)m->owners.buf)[slot->idx] = owner; \
+		\
+		if (out != NULL) { \
+			out->idx = owner; \
+			out->gen = slot->gen; \
+		} \
+		return 0; \
+	} \
+	\
+	static inline int NAME##_remove(NAME##_t *m, slotmap_handle_t h) { \
+		if (!NAME##_contains(m, h)) \
+			return -1; \
+		\
+		slotmap_slot_t *slots  = (slotmap_slot_t*)m->slots.buf; \
+		uint32_t       *owners = (uint32_t*)m->owners.buf; \
+		TYPE           *values = (TYPE*)m->values.buf; \
+		\
+		/* Move the last element into the hole to keep the elements packed */ \
+		uint32_t idx = slots[h.idx].idx, last = (uint32_t)(m->values.count - 1); \
+		if (idx != last) { \
+			values[idx] = values[last]; \
+			owners[idx] = owners[last]; \
+			slots[owners[idx]].idx = idx; \
+		} \
+		\
+		-- m->values.count; \
+		-- m->owners.count; \
+		\
+		++ slots[h.idx].gen; \
+		slots[h.idx].idx = m->free_head; \
+		m->free_head     = h.idx; \
+		return 0; \
+	} \
+	\
+	static inline void NAME##_clear(NAME##_t *m) { \
+		uint32_t *owners = (uint32_t*)m->owners.buf; \
+		for (size_t i = 0; i < m->owners.count; ++ i) { \
+			slotmap_slot_t *slot = &((slotmap_slot_t*)m->slots.buf)[owners[i]]; \
+			++ slot->gen; \
+			slot->idx    = m->free_head; \
+			m->free_head = owners[i]; \
+		} \
+		\
+		m->values.count = 0; \
+		m->owners.count = 0; \
+	} \
+	\
+	static inline TYPE *NAME##_data(NAME##_t *m) { \
+		return (TYPE*)m->values.buf; \
+	} \
+	\
+	static inline slotmap_handle_t NAME##_handle_at(NAME##_t *m, size_t idx) { \
+		slotmap_handle_t h; \
+		h.idx = ((uint32_t*)m->owners.buf)[idx]; \
+		h.gen = ((slotmap_slot_t*)m->slots.buf)[h.idx].gen; \
+		return h; \
+	}
+
+/*
+ * SLOTMAP_DEFINE(NAME, TYPE)
+ *     Defines a slot map type 'NAME'_t of elements of type 'TYPE', along with its functions. The
+ *     elements are stored packed in 'values', and each one has a slot in 'slots' which points to
+ *     it. A handle is the index of a slot and its generation: removing an element changes the
+ *     generation of its slot, so the old handles of a reused slot no longer match. Example:
+ *         | SLOTMAP_DEFINE(entities, entity_t)
+ *         |
+ *         | slotmap_handle_t player;
+ *         | if (entities_add(&world, new_player(), &player) != 0)
+ *         |     FATAL_FUNC_FAIL("entities_add");
+ *
+ *     'NAME'_t
+ *         darray_t values
+ *             The elements, packed
+ *         darray_t owners
+ *             The slot index of each element (uint32_t)
+ *         darray_t slots
+ *             The slots (slotmap_slot_t)
+ *         uint32_t free_head
+ *             The first free slot, SLOTMAP_NONE if there is none
+ *
+ *     void 'NAME'_init('NAME'_t *m)
+ *         Initializes 'm' as empty. Does not allocate.
+ *
+ *     void 'NAME'_init_with('NAME'_t *m, const allocator_t *a)
+ *         Same as 'NAME'_init, but 'm' allocates with 'a'.
+ *
+ *     void 'NAME'_free('NAME'_t *m)
+ *         Frees 'm'.
+ *
+ *     int 'NAME'_reserve('NAME'_t *m, size_t count)
+ *         Makes sure 'm' has space for 'count' elements. Returns 0 on success.
+ *
+ *     int 'NAME'_add('NAME'_t *m, TYPE value, slotmap_handle_t *out)
+ *         Adds 'value' to 'm' and writes its handle to 'out', if 'out' is not NULL. Returns 0 on
+ *         success.
+ *
+ *     bool 'NAME'_contains('NAME'_t *m, slotmap_handle_t h)
+ *         Returns true if 'h' refers to an element of 'm'.
+ *
+ *     TYPE *'NAME'_get('NAME'_t *m, slotmap_handle_t h)
+ *         Returns a pointer to the element of 'h', or NULL if 'h' is stale. The pointer is
+ *         invalidated by adding and removing elements, the handle is not.
+ *
+ *     int 'NAME'_remove('NAME'_t *m, slotmap_handle_t h)
+ *         Removes the element of 'h' from 'm' by moving the last element into its place. Returns
+ *         -1 if 'h' is stale.
+ *
+ *     void 'NAME'_clear('NAME'_t *m)
+ *         Removes all the elements of 'm', invalidating all the handles.
+ *
+ *     TYPE *'NAME'_data('NAME'_t *m)
+ *         Returns the packed elements of 'm', there are 'values.count' of them.
+ *
+ *     slotmap_handle_t 'NAME'_handle_at('NAME'_t *m, size_t idx)
+ *         Returns the handle of the element at the index 'idx' of the packed elements.
+ */
+
+#ifdef __cplusplus
+}
+#endif
+#endif
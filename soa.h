@@ -0,0 +1,272 @@
+/*
+ * This library is a part of the C header-only libraries collection
+ * (https://github.com/LordOfTrident/chol)
+ *
+ * This library has no implementation section, the containers are generated with a macro into
+ * static inline functions, so it can be included anywhere without defining an implementation
+ * macro.
+ *
+ * This library provides a structure-of-arrays container. Instead of storing whole records next
+ * to each other like darray_t, it stores each field in its own buffer, so a loop over one field
+ * only loads that field into the cache and can be vectorized.
+ */
+
+/* Simple example of the library:
+#include <stdio.h>
+
+#include <chol/soa.h>
+
+#define PARTICLE_FIELDS(X) \
+	X(float, x) \
+	X(float, vel)
+
+SOA_DEFINE(particles, PARTICLE_FIELDS)
+
+int main(void) {
+	particles_t ps;
+	particles_init(&ps);
+
+	particles_push(&ps, 0, 1.5f);
+	particles_push(&ps, 4, -2);
+
+	for (size_t i = 0; i < ps.count; ++ i)
+		ps.x[i] += ps.vel[i];
+
+	printf("%f %f\n", ps.x[0], ps.x[1]);
+
+	particles_free(&ps);
+	return 0;
+}
+*/
+
+#ifndef CHOL_SOA_H_HEADER_GUARD
+#define CHOL_SOA_H_HEADER_GUARD
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>  /* size_t */
+#include <string.h>  /* memcpy, memset */
+#include <stdint.h>  /* SIZE_MAX, uintptr_t */
+#include <assert.h>  /* assert */
+
+#include "alloc.h"
+
+#define CHOL_SOA_VERSION_MAJOR 1
+#define CHOL_SOA_VERSION_MINOR 0
+#define CHOL_SOA_VERSION_PATCH 0
+
+/*
+ * 1.0.0: Structure-of-arrays container generated from a field list
+ */
+
+#ifndef SOA_CHUNK_SIZE
+#	define SOA_CHUNK_SIZE 32
+#endif
+
+#ifndef SOA_GROWTH_NUM
+#	define SOA_GROWTH_NUM 2
+#endif
+
+#ifndef SOA_GROWTH_DEN
+#	define SOA_GROWTH_DEN 1
+#endif
+
+#ifndef SOA_ALIGN
+#	define SOA_ALIGN 64
+#endif
+
+/*
+ * SOA_CHUNK_SIZE
+ *     The smallest capacity allocated by a SoA container in elements. If not defined before
+ *     including, the default is 32.
+ *
+ * SOA_GROWTH_NUM, SOA_GROWTH_DEN
+ *     The growth factor of SoA containers, same as DARRAY_GROWTH_NUM and DARRAY_GROWTH_DEN. If
+ *     not defined before including, the default is 2 / 1.
+ *
+ * SOA_ALIGN
+ *     The alignment of each column in bytes. If not defined before including, the default is 64
+ *     (a cache line), which is enough for any SIMD load. Has to be a power of 2.
+ */
+
+/* Adds the size of a column of 'size' elements of 'elem_size' bytes, padded to SOA_ALIGN, to
+   'bytes'. Returns -1 on overflow. */
+static inline int soa_add_column(size_t *bytes, size_t size, size_t elem_size) {
+	if (size > (SIZE_MAX - SOA_ALIGN) / elem_size)
+		return -1;
+
+	size_t column = (size * elem_size + SOA_ALIGN - 1) & ~(size_t)(SOA_ALIGN - 1);
+	if (column > SIZE_MAX - *bytes)
+		return -1;
+
+	*bytes += column;
+	return 0;
+}
+
+static inline char *soa_align(char *ptr) {
+	uintptr_t addr = (uintptr_t)ptr;
+	return ptr + (((addr + SOA_ALIGN - 1) & ~(uintptr_t)(SOA_ALIGN - 1)) - addr);
+}
+
+#define SOA_FIELD_DECL(TYPE, NAME)  TYPE *NAME;
+#define SOA_FIELD_PARAM(TYPE, NAME) , TYPE NAME
+#define SOA_FIELD_SET(TYPE, NAME)   s->NAME[s->count] = NAME;
+#define SOA_FIELD_BYTES(TYPE, NAME) \
+	if (soa_add_column(&bytes, size, sizeof(TYPE)) != 0) \
+		return -1;
+#define SOA_FIELD_MOVE(TYPE, NAME) \
+	if (s->count > 0) \
+		memcpy(at, s->NAME, s->count * sizeof(TYPE)); \
+	s->NAME = (TYPE*)at; \
+	at = soa_align(at + size * sizeof(TYPE));
+#define SOA_FIELD_ZERO(TYPE, NAME) \
+	memset(&s->NAME[s->count], 0, (count - s->count) * sizeof(TYPE));
+#define SOA_FIELD_SWAP_REMOVE(TYPE, NAME) \
+	s->NAME[idx] = s->NAME[s->count];
+
+#define SOA_DEFINE(NAME, FIELDS) \
+	typedef struct { \
+		FIELDS(SOA_FIELD_DECL) \
+		\
+		size_t count, size; \
+		void  *block; \
+		\
+		const allocator_t *allocator; \
+	} NAME##_t; \
+	\
+	static inline void NAME##_init_with(NAME##_t *s, const allocator_t *a) { \
+		memset(s, 0, sizeof(*s)); \
+		s->allocator = a; \
+	} \
+	\
+	static inline void NAME##_init(NAME##_t *s) { \
+		NAME##_init_with(s, NULL); \
+	} \
+	\
+	static inline void NAME##_free(NAME##_t *s) { \
+		allocator_free(s->allocator, s->block); \
+		NAME##_init_with(s, s->allocator); \
+	} \
+	\
+	static inline int NAME##_reserve(NAME##_t *s, size_t size) { \
+		if (size <= s->size) \
+			return 0; \
+		\
+		size_t bytes = SOA_ALIGN; \
+		FIELDS(SOA_FIELD_BYTES) \
+		\
+		char *block = (char*)allocator_alloc(s->allocator, bytes); \
+		if (block == NULL) \
+			return -1; \
+		\
+		char *at = soa_align(block); \
+		FIELDS(SOA_FIELD_MOVE) \
+		(void)at; \
+		\
+		allocator_free(s->allocator, s->block); \
+		s->block = block; \
+		s->size  = size; \
+		return 0; \
+	} \
+	\
+	static inline int NAME##_grow(NAME##_t *s, size_t needed) { \
+		size_t size = s->size > SIZE_MAX / SOA_GROWTH_NUM? \
+		              SIZE_MAX : s->size * SOA_GROWTH_NUM / SOA_GROWTH_DEN; \
+		if (size < SOA_CHUNK_SIZE) \
+			size = SOA_CHUNK_SIZE; \
+		if (size < needed) \
+			size = needed; \
+		\
+		return NAME##_reserve(s, size); \
+	} \
+	\
+	static inline int NAME##_push(NAME##_t *s FIELDS(SOA_FIELD_PARAM)) { \
+		if (s->count >= s->size) { \
+			if (NAME##_grow(s, s->count + 1) != 0) \
+				return -1; \
+		} \
+		\
+		FIELDS(SOA_FIELD_SET) \
+		++ s->count; \
+		return 0; \
+	} \
+	\
+	static inline int NAME##_resize(NAME##_t *s, size_t count) { \
+		if (count > s->size) { \
+			if (NAME##_grow(s, count) != 0) \
+				return -1; \
+		} \
+		\
+		if (count > s->count) { \
+			FIELDS(SOA_FIELD_ZERO) \
+		} \
+		\
+		s->count = count; \
+		return 0; \
+	} \
+	\
+	static inline void NAME##_swap_remove(NAME##_t *s, size_t idx) { \
+		assert(idx < s->count); \
+		-- s->count; \
+		FIELDS(SOA_FIELD_SWAP_REMOVE) \
+	}
+
+/*
+ * SOA_DEFINE(NAME, FIELDS)
+ *     Defines a structure-of-arrays type 'NAME'_t along with its functions. 'FIELDS' is the name of
+ *     a field list macro, which takes a macro 'X' and calls it with the type and the name of each
+ *     field. Example:
+ *         | #define PARTICLE_FIELDS(X) \
+ *         |     X(float, x) \
+ *         |     X(float, y) \
+ *         |     X(int,   id)
+ *         |
+ *         | SOA_DEFINE(particles, PARTICLE_FIELDS)
+ *
+ *     All the columns live in a single allocation, each aligned to SOA_ALIGN, so they always
+ *     have the same capacity and grow together with one reallocation. The fields cannot be named
+ *     'count', 'size', 'block' or 'allocator'.
+ *
+ *     'NAME'_t
+ *         TYPE *'field'
+ *             Pointer to the column of each field, indexed by the element index. The pointers
+ *             are invalidated when the container grows.
+ *         size_t count
+ *             Count of elements
+ *         size_t size
+ *             Allocated capacity of each column (in elements)
+ *         void *block
+ *             The allocation holding all the columns
+ *         const allocator_t *allocator
+ *             The allocator of the columns, NULL for libc (see alloc.h)
+ *
+ *     The functions that return int return 0 on success and -1 on failure (allocation fail or a
+ *     size that would overflow), in which case the container is left unchanged.
+ *
+ *     void 'NAME'_init('NAME'_t *s)
+ *         Initializes 's' as empty. Does not allocate.
+ *
+ *     void 'NAME'_init_with('NAME'_t *s, const allocator_t *a)
+ *         Same as 'NAME'_init, but 's' allocates with 'a'.
+ *
+ *     void 'NAME'_free('NAME'_t *s)
+ *         Frees 's'.
+ *
+ *     int 'NAME'_reserve('NAME'_t *s, size_t size)
+ *         Makes sure every column of 's' has space for at least 'size' elements.
+ *
+ *     int 'NAME'_push('NAME'_t *s, ...)
+ *         Appends an element to 's'. Takes the value of each field in the order of 'FIELDS'.
+ *
+ *     int 'NAME'_resize('NAME'_t *s, size_t count)
+ *         Sets the count of elements in 's' to 'count'. New elements are zero initialized.
+ *
+ *     void 'NAME'_swap_remove('NAME'_t *s, size_t idx)
+ *         Removes the element at 'idx' from 's' by moving the last element into its place.
+ */
+
+#ifdef __cplusplus
+}
+#endif
+#endif
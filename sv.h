@@ -31,17 +31,24 @@ int main(void) {
 extern "C" {
 #endif
 
-#include <string.h>  /* strlen */
+#include <string.h>  /* strlen, memchr, memset */
+#include <stdint.h>  /* uint8_t */
 #include <stdbool.h> /* bool, true, false */
 
 #define CHOL_SV_VERSION_MAJOR 1
-#define CHOL_SV_VERSION_MINOR 1
+#define CHOL_SV_VERSION_MINOR 5
 #define CHOL_SV_VERSION_PATCH 1
 
 /*
  * 1.0.0: String view structure, basic functions for trimming, finding, substring...
  * 1.1.0: Support C++
  * 1.1.1: Fix has_prefix, has_suffix
+ * 1.2.0: Vectorize the character search functions
+ * 1.3.0: Two-Way substring search, precompiled searchers
+ * 1.4.0: Character sets, set versions of trim and find, spans
+ * 1.5.0: memcmp-based equality, three-way comparison, case-insensitive comparison, common prefix
+ *        length, fix has_suffix
+ * 1.5.1: SSE2 path for the set functions
  */
 
 #ifndef CONSTRUCT
@@ -99,7 +106,11 @@ sv_t sv_cstr(const char *cstr)             {return sv_new(cstr, strlen(cstr));}
 char sv_at(     sv_t sv, size_t idx) {return sv.cstr[idx];}
 bool sv_is_null(sv_t sv)             {return sv.cstr == NULL;}
 
-bool sv_is_equal(sv_t sv, sv_t to);
+bool   sv_is_equal(       sv_t sv, sv_t to);
+bool   sv_is_equal_nocase(sv_t sv, sv_t to);
+int    sv_compare(        sv_t sv, sv_t to);
+int    sv_compare_nocase( sv_t sv, sv_t to);
+size_t sv_common_prefix(  sv_t sv, sv_t to);
 
 /*
  * sv_t sv_new(const char *cstr, size_t len)
@@ -115,7 +126,23 @@ bool sv_is_equal(sv_t sv, sv_t to);
  *     Returns true if 'sv' is SV_NULL.
  *
  * bool sv_is_equal(sv_t sv, sv_t to)
- *     Returns true if 'sv' is equal to 'to'.
+ *     Returns true if 'sv' is equal to 'to'. The lengths are compared first, then the chars with
+ *     memcmp.
+ *
+ * bool sv_is_equal_nocase(sv_t sv, sv_t to)
+ *     Same as sv_is_equal, but ignores the case of ASCII letters.
+ *
+ * int sv_compare(sv_t sv, sv_t to)
+ *     Returns a negative value if 'sv' is ordered before 'to', 0 if they are equal and a positive
+ *     value if 'sv' is ordered after 'to'. The chars are compared as unsigned (like memcmp), and a
+ *     string is ordered before all the longer strings it is a prefix of.
+ *
+ * int sv_compare_nocase(sv_t sv, sv_t to)
+ *     Same as sv_compare, but compares ASCII letters as lowercase.
+ *
+ * size_t sv_common_prefix(sv_t sv, sv_t to)
+ *     Returns the length of the longest common prefix of 'sv' and 'to'. Compares 32 chars per
+ *     step with AVX2 or 16 with SSE2.
  */
 
 bool sv_has_prefix(sv_t sv, sv_t prefix);
@@ -171,11 +198,127 @@ size_t sv_find_substr(    sv_t sv, sv_t substr);
  * size_t sv_find_last_not(sv_t sv, char ch)
  *     Return the index of the last char that is not 'ch' in 'sv'. On failure returns SV_NPOS.
  *
+ *     sv_contains and sv_find_first use memchr. The other character search functions compare 32
+ *     characters per step with AVX2 or 16 with SSE2 when the compiler targets them (define
+ *     SV_NO_SIMD before including the implementation to always use plain loops).
+ *
  * bool sv_contains_substr(sv_t sv, sv_t substr)
  *     Return true if 'sv' contains the substring 'substr'
  *
  * size_t sv_find_substr(sv_t sv, sv_t substr)
  *     Return the index of 'substr' substring in 'sv'. On failure returns SV_NPOS.
+ *
+ *     Substrings of up to SV_SHORT_NEEDLE chars are found by comparing their first and last
+ *     char with 32 (AVX2) or 16 (SSE2) positions of 'sv' at once, and only comparing the whole
+ *     substring where both match. Longer substrings use the Two-Way algorithm, which runs in
+ *     O(sv.len + substr.len) time and skips ahead on mismatching chars like Boyer-Moore-Horspool.
+ *     An empty 'substr' is found at 0.
+ */
+
+#ifndef SV_SHORT_NEEDLE
+#	define SV_SHORT_NEEDLE 32
+#endif
+
+typedef struct {
+	sv_t   needle;
+	size_t ms, period;
+	bool   periodic;
+	size_t shift[256];
+} sv_searcher_t;
+
+void   sv_searcher_init(sv_searcher_t *s, sv_t needle);
+size_t sv_searcher_find(const sv_searcher_t *s, sv_t sv);
+
+/*
+ * SV_SHORT_NEEDLE
+ *     Length up to which a substring is searched for without the Two-Way preprocessing. If not
+ *     defined before including, the default is 32.
+ *
+ * sv_searcher_t
+ *     Precompiled substring (needle), to search for the same substring in many strings without
+ *     preprocessing it each time. It does not copy the substring, so the substring has to stay
+ *     valid while the searcher is used.
+ *
+ *     sv_t needle
+ *         The substring
+ *     size_t ms, period
+ *         The critical factorization and the period of the substring (Two-Way)
+ *     bool periodic
+ *         True if the whole substring has the period 'period'
+ *     size_t shift[256]
+ *         For each char, one past the index of its last occurrence in the substring, 0 if it
+ *         does not occur
+ *
+ * void sv_searcher_init(sv_searcher_t *s, sv_t needle)
+ *     Precompiles 'needle' into 's'.
+ *
+ * size_t sv_searcher_find(const sv_searcher_t *s, sv_t sv)
+ *     Same as sv_find_substr(sv, s->needle).
+ */
+
+typedef struct {
+	uint8_t bits[32];
+} sv_charset_t;
+
+extern const sv_charset_t sv_charset_whitespaces;
+
+#define SV_CHARSET_WHITESPACES (&sv_charset_whitespaces)
+
+sv_charset_t sv_charset(     const char *chs);
+void         sv_charset_add( sv_charset_t *set, char ch);
+bool         sv_charset_has( const sv_charset_t *set, char ch);
+
+sv_t sv_trim_front_set(sv_t sv, const sv_charset_t *set);
+sv_t sv_trim_back_set( sv_t sv, const sv_charset_t *set);
+sv_t sv_trim_set(      sv_t sv, const sv_charset_t *set);
+
+size_t sv_find_first_of(    sv_t sv, const sv_charset_t *set);
+size_t sv_find_first_not_of(sv_t sv, const sv_charset_t *set);
+size_t sv_find_last_of(     sv_t sv, const sv_charset_t *set);
+size_t sv_find_last_not_of( sv_t sv, const sv_charset_t *set);
+
+size_t sv_span( sv_t sv, const sv_charset_t *set);
+size_t sv_cspan(sv_t sv, const sv_charset_t *set);
+
+/*
+ * sv_charset_t
+ *     Set of chars, a 256-bit bitmap. The bit of char 'c' is the bit '(c >> 4) & 7' of the byte
+ *     '(c >> 7) * 16 + (c & 15)', so 16 chars can be tested with two table lookups (SSSE3/AVX2
+ *     shuffles), 32 per step with AVX2 and 16 with SSSE3. With only SSE2, 16 chars per step are
+ *     compared against the ranges of consecutive chars in the set instead, if it has at most 8 of
+ *     them (like SV_CHARSET_WHITESPACES or the alphanumeric chars) and the string is at least 64
+ *     chars long. Build a set once and reuse it instead of passing a string of chars to each
+ *     call.
+ *
+ * SV_CHARSET_WHITESPACES
+ *     Pointer to the set of SV_WHITESPACES.
+ *
+ * sv_charset_t sv_charset(const char *chs)
+ *     Returns the set of the chars in the C string 'chs'.
+ *
+ * void sv_charset_add(sv_charset_t *set, char ch)
+ *     Adds 'ch' to 'set'.
+ *
+ * bool sv_charset_has(const sv_charset_t *set, char ch)
+ *     Returns true if 'ch' is in 'set'.
+ *
+ * sv_t sv_trim_front_set(sv_t sv, const sv_charset_t *set)
+ * sv_t sv_trim_back_set(sv_t sv, const sv_charset_t *set)
+ * sv_t sv_trim_set(sv_t sv, const sv_charset_t *set)
+ *     Same as sv_trim_front, sv_trim_back and sv_trim, but take a set.
+ *
+ * size_t sv_find_first_of(sv_t sv, const sv_charset_t *set)
+ * size_t sv_find_first_not_of(sv_t sv, const sv_charset_t *set)
+ * size_t sv_find_last_of(sv_t sv, const sv_charset_t *set)
+ * size_t sv_find_last_not_of(sv_t sv, const sv_charset_t *set)
+ *     Return the index of the first/last char of 'sv' that is/is not in 'set'. On failure
+ *     returns SV_NPOS.
+ *
+ * size_t sv_span(sv_t sv, const sv_charset_t *set)
+ *     Return the length of the prefix of 'sv' made of chars in 'set' (like strspn).
+ *
+ * size_t sv_cspan(sv_t sv, const sv_charset_t *set)
+ *     Return the length of the prefix of 'sv' made of chars not in 'set' (like strcspn).
  */
 
 #ifdef __cplusplus
@@ -184,42 +327,215 @@ size_t sv_find_substr(    sv_t sv, sv_t substr);
 #endif
 
 #ifdef CHOL_SV_IMPLEMENTATION
+#ifndef SV_NO_SIMD
+#	if defined(__AVX2__)
+#		define SV_AVX2
+#		include <immintrin.h> /* _mm256_loadu_si256, _mm256_cmpeq_epi8, _mm256_movemask_epi8 */
+#	endif
+#	if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#		define SV_SSE2
+#		include <emmintrin.h> /* _mm_loadu_si128, _mm_cmpeq_epi8, _mm_movemask_epi8 */
+#	endif
+#	if defined(__SSSE3__)
+#		define SV_SSSE3
+#		include <tmmintrin.h> /* _mm_shuffle_epi8 */
+#	endif
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#	include <intrin.h> /* _BitScanForward, _BitScanReverse */
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#if defined(SV_SSE2) || defined(SV_AVX2)
+/* Returns the index of the lowest set bit of 'x', which must not be 0 */
+static size_t sv_ctz(unsigned x) {
+#if defined(__GNUC__) || defined(__clang__)
+	return (size_t)__builtin_ctz(x);
+#elif defined(_MSC_VER)
+	unsigned long idx;
+	_BitScanForward(&idx, x);
+	return idx;
+#else
+	size_t idx = 0;
+	while ((x & 1) == 0) {
+		x >>= 1;
+		++ idx;
+	}
+
+	return idx;
+#endif
+}
+
+/* Returns the index of the highest set bit of 'x', which must not be 0 */
+static size_t sv_log2(unsigned x) {
+#if defined(__GNUC__) || defined(__clang__)
+	return sizeof(unsigned) * 8 - 1 - (size_t)__builtin_clz(x);
+#elif defined(_MSC_VER)
+	unsigned long idx;
+	_BitScanReverse(&idx, x);
+	return idx;
+#else
+	size_t idx = 0;
+	while (x >>= 1)
+		++ idx;
+
+	return idx;
+#endif
+}
+#endif
+
+/* Returns the index of the first char of 'str' that is equal to 'ch', or if 'not_' is true, the
+   first one that is not. The SIMD loops compare a whole block at once and then locate the match
+   in its mask, inverting the mask for 'not_' */
+static size_t sv_scan_first(const char *str, size_t len, char ch, bool not_) {
+	size_t i = 0;
+#ifdef SV_AVX2
+	__m256i  needle32 = _mm256_set1_epi8(ch);
+	unsigned flip32   = not_? 0xFFFFFFFF : 0;
+	for (; i + 32 <= len; i += 32) {
+		__m256i  block = _mm256_loadu_si256((const __m256i*)(str + i));
+		unsigned mask  = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle32));
+		mask ^= flip32;
+		if (mask != 0)
+			return i + sv_ctz(mask);
+	}
+#endif
+
+#ifdef SV_SSE2
+	__m128i  needle16 = _mm_set1_epi8(ch);
+	unsigned flip16   = not_? 0xFFFF : 0;
+	for (; i + 16 <= len; i += 16) {
+		__m128i  block = _mm_loadu_si128((const __m128i*)(str + i));
+		unsigned mask  = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle16)) ^ flip16;
+		if (mask != 0)
+			return i + sv_ctz(mask);
+	}
+#endif
+
+	for (; i < len; ++ i) {
+		if ((str[i] == ch) != not_)
+			return i;
+	}
+
+	return SV_NPOS;
+}
+
+/* Same as sv_scan_first, but returns the last matching char */
+static size_t sv_scan_last(const char *str, size_t len, char ch, bool not_) {
+	size_t i = len;
+#ifdef SV_AVX2
+	__m256i  needle32 = _mm256_set1_epi8(ch);
+	unsigned flip32   = not_? 0xFFFFFFFF : 0;
+	for (; i >= 32; i -= 32) {
+		__m256i  block = _mm256_loadu_si256((const __m256i*)(str + i - 32));
+		unsigned mask  = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle32));
+		mask ^= flip32;
+		if (mask != 0)
+			return i - 32 + sv_log2(mask);
+	}
+#endif
+
+#ifdef SV_SSE2
+	__m128i  needle16 = _mm_set1_epi8(ch);
+	unsigned flip16   = not_? 0xFFFF : 0;
+	for (; i >= 16; i -= 16) {
+		__m128i  block = _mm_loadu_si128((const __m128i*)(str + i - 16));
+		unsigned mask  = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle16)) ^ flip16;
+		if (mask != 0)
+			return i - 16 + sv_log2(mask);
+	}
+#endif
+
+	while (i -- > 0) {
+		if ((str[i] == ch) != not_)
+			return i;
+	}
+
+	return SV_NPOS;
+}
+
+/* memcmp, but 'len' can be 0 with NULL pointers */
+static int sv_memcmp(const char *a, const char *b, size_t len) {
+	return len == 0? 0 : memcmp(a, b, len);
+}
+
+static unsigned char sv_lower(char ch) {
+	unsigned char c = (unsigned char)ch;
+	return c >= 'A' && c <= 'Z'? (unsigned char)(c + ('a' - 'A')) : c;
+}
+
 bool sv_is_equal(sv_t sv, sv_t to) {
-	size_t len = sv.len > to.len? sv.len : to.len;
+	return sv.len == to.len && sv_memcmp(sv.cstr, to.cstr, sv.len) == 0;
+}
+
+bool sv_is_equal_nocase(sv_t sv, sv_t to) {
+	return sv.len == to.len && sv_compare_nocase(sv, to) == 0;
+}
+
+int sv_compare(sv_t sv, sv_t to) {
+	int cmp = sv_memcmp(sv.cstr, to.cstr, sv.len < to.len? sv.len : to.len);
+	if (cmp != 0)
+		return cmp;
+
+	return sv.len < to.len? -1 : sv.len > to.len;
+}
+
+int sv_compare_nocase(sv_t sv, sv_t to) {
+	size_t len = sv.len < to.len? sv.len : to.len;
 	for (size_t i = 0; i < len; ++ i) {
-		if (sv_at(sv, i) != sv_at(to, i))
-			return false;
+		/* Only fold the case of the chars that differ */
+		if (sv.cstr[i] == to.cstr[i])
+			continue;
+
+		unsigned char a = sv_lower(sv.cstr[i]), b = sv_lower(to.cstr[i]);
+		if (a != b)
+			return a < b? -1 : 1;
 	}
 
-	return true;
+	return sv.len < to.len? -1 : sv.len > to.len;
 }
 
-bool sv_has_prefix(sv_t sv, sv_t prefix) {
-	if (sv.len < prefix.len)
-		return false;
+size_t sv_common_prefix(sv_t sv, sv_t to) {
+	size_t len = sv.len < to.len? sv.len : to.len, i = 0;
+#ifdef SV_AVX2
+	for (; i + 32 <= len; i += 32) {
+		__m256i  a    = _mm256_loadu_si256((const __m256i*)(sv.cstr + i));
+		__m256i  b    = _mm256_loadu_si256((const __m256i*)(to.cstr + i));
+		unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)) ^ 0xFFFFFFFF;
+		if (mask != 0)
+			return i + sv_ctz(mask);
+	}
+#endif
 
-	for (size_t i = 0; i < prefix.len; ++ i) {
-		if (sv_at(sv, i) != sv_at(prefix, i))
-			return false;
+#ifdef SV_SSE2
+	for (; i + 16 <= len; i += 16) {
+		__m128i  a    = _mm_loadu_si128((const __m128i*)(sv.cstr + i));
+		__m128i  b    = _mm_loadu_si128((const __m128i*)(to.cstr + i));
+		unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) ^ 0xFFFF;
+		if (mask != 0)
+			return i + sv_ctz(mask);
 	}
+#endif
+
+	while (i < len && sv.cstr[i] == to.cstr[i])
+		++ i;
 
-	return true;
+	return i;
+}
+
+bool sv_has_prefix(sv_t sv, sv_t prefix) {
+	return sv.len >= prefix.len && sv_memcmp(sv.cstr, prefix.cstr, prefix.len) == 0;
 }
 
 bool sv_has_suffix(sv_t sv, sv_t suffix) {
 	if (sv.len < suffix.len)
 		return false;
 
-	for (size_t i = sv.len - suffix.len; i < sv.len; ++ i) {
-		if (sv_at(sv, i) != sv_at(suffix, i))
-			return false;
-	}
-
-	return true;
+	return suffix.len == 0 || memcmp(sv.cstr + (sv.len - suffix.len), suffix.cstr, suffix.len) == 0;
 }
 
 sv_t sv_substr(sv_t sv, size_t start, size_t len) {
@@ -237,123 +553,472 @@ sv_t sv_substr(sv_t sv, size_t start, size_t len) {
 }
 
 sv_t sv_trim_front(sv_t sv, const char *chs) {
-	sv_t matches = sv_cstr(chs);
-	sv_t trimmed = sv;
-	for (size_t i = 0; i < sv.len; ++ i) {
-		if (!sv_contains(matches, sv_at(sv, i)))
-			break;
+	sv_charset_t set = sv_charset(chs);
+	return sv_trim_front_set(sv, &set);
+}
 
-		++ trimmed.cstr;
-		-- trimmed.len;
-	}
+sv_t sv_trim_back(sv_t sv, const char *chs) {
+	sv_charset_t set = sv_charset(chs);
+	return sv_trim_back_set(sv, &set);
+}
 
-	return trimmed;
+sv_t sv_trim(sv_t sv, const char *chs) {
+	sv_charset_t set = sv_charset(chs);
+	return sv_trim_set(sv, &set);
 }
 
-sv_t sv_trim_back(sv_t sv, const char *chs) {
-	sv_t matches = sv_cstr(chs);
-	sv_t trimmed = sv;
-	for (size_t i = sv.len - 1; i != SV_NPOS; -- i) {
-		if (!sv_contains(matches, sv_at(sv, i)))
-			break;
+const sv_charset_t sv_charset_whitespaces = {{
+	0x04, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 0, 0, /* ' ', '\t' to '\r' */
+	0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+}};
 
-		-- trimmed.len;
-	}
+sv_charset_t sv_charset(const char *chs) {
+	sv_charset_t set;
+	memset(&set, 0, sizeof(set));
+	for (; *chs != '\0'; ++ chs)
+		sv_charset_add(&set, *chs);
 
-	return trimmed;
+	return set;
 }
 
-sv_t sv_trim(sv_t sv, const char *chs) {
-	sv =   sv_trim_front(sv, chs);
-	return sv_trim_back( sv, chs);
+void sv_charset_add(sv_charset_t *set, char ch) {
+	unsigned char c = (unsigned char)ch;
+	set->bits[(c >> 7) * 16 + (c & 15)] |= (uint8_t)(1 << ((c >> 4) & 7));
 }
 
-bool sv_contains(sv_t sv, char ch) {
-	for (size_t i = 0; i < sv.len; ++ i) {
-		if (sv_at(sv, i) == ch)
-			return true;
+bool sv_charset_has(const sv_charset_t *set, char ch) {
+	unsigned char c = (unsigned char)ch;
+	return (set->bits[(c >> 7) * 16 + (c & 15)] >> ((c >> 4) & 7)) & 1;
+}
+
+#ifdef SV_AVX2
+/* Returns 0xFF for each char of 'x' that is in the set with the bitmap halves 'lo' and 'hi' */
+static __m256i sv_classify32(__m256i x, __m256i lo, __m256i hi) {
+	const __m256i nibble = _mm256_set1_epi8(0x0F);
+	const __m256i bit    = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64,
+	                                        -128, 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32,
+	                                        64, -128);
+
+	__m256i low  = _mm256_and_si256(x, nibble);
+	__m256i high = _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble);
+	__m256i row  = _mm256_blendv_epi8(_mm256_shuffle_epi8(lo, low), _mm256_shuffle_epi8(hi, low),
+	                                  _mm256_cmpgt_epi8(high, _mm256_set1_epi8(7)));
+	__m256i mask = _mm256_shuffle_epi8(bit, high);
+	return _mm256_cmpeq_epi8(_mm256_and_si256(row, mask), mask);
+}
+#endif
+
+#ifdef SV_SSSE3
+/* Same as sv_classify32, for 16 chars */
+static __m128i sv_classify16(__m128i x, __m128i lo, __m128i hi) {
+	const __m128i nibble = _mm_set1_epi8(0x0F);
+	const __m128i bit    = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64,
+	                                     -128);
+
+	__m128i low   = _mm_and_si128(x, nibble);
+	__m128i high  = _mm_and_si128(_mm_srli_epi16(x, 4), nibble);
+	__m128i upper = _mm_cmpgt_epi8(high, _mm_set1_epi8(7));
+	__m128i row   = _mm_or_si128(_mm_andnot_si128(upper, _mm_shuffle_epi8(lo, low)),
+	                             _mm_and_si128(upper, _mm_shuffle_epi8(hi, low)));
+	__m128i mask  = _mm_shuffle_epi8(bit, high);
+	return _mm_cmpeq_epi8(_mm_and_si128(row, mask), mask);
+}
+#endif
+
+#if defined(SV_SSE2) && !defined(SV_SSSE3)
+/* Without SSSE3 there is no shuffle to look up the bitmap with, so SSE2 tests the chars against
+   the ranges of consecutive chars in the set instead. Converting the set costs a pass over all
+   256 chars, which only pays off for longer strings */
+#	define SV_SET_RANGES  8
+#	define SV_SET_MIN_LEN 64
+
+/* Writes the first char and the width of each range of 'set' into 'first' and 'width'. Returns
+   the count of ranges, or SV_NPOS if there are more than SV_SET_RANGES */
+static size_t sv_set_ranges(const sv_charset_t *set, __m128i *first, __m128i *width) {
+	unsigned char lo[SV_SET_RANGES], hi[SV_SET_RANGES];
+	size_t        count = 0;
+	for (unsigned c = 0; c < 256; ++ c) {
+		if (!sv_charset_has(set, (char)c))
+			continue;
+
+		if (count > 0 && hi[count - 1] + 1u == c)
+			hi[count - 1] = (unsigned char)c;
+		else if (count == SV_SET_RANGES)
+			return SV_NPOS;
+		else {
+			lo[count] = hi[count] = (unsigned char)c;
+			++ count;
+		}
+	}
+
+	for (size_t r = 0; r < count; ++ r) {
+		first[r] = _mm_set1_epi8((char)lo[r]);
+		width[r] = _mm_set1_epi8((char)(hi[r] - lo[r]));
 	}
 
-	return false;
+	return count;
 }
 
-size_t sv_find_first(sv_t sv, char ch) {
-	for (size_t i = 0; i < sv.len; ++ i) {
-		if (sv_at(sv, i) == ch)
-			return i;
+/* Returns 0xFF for each char of 'x' that is in one of the 'count' ranges. A char is in a range if
+   its distance from the first char, saturated, does not exceed the width */
+static __m128i sv_classify16_ranges(__m128i x, const __m128i *first, const __m128i *width,
+                                    size_t count) {
+	const __m128i zero = _mm_setzero_si128();
+
+	__m128i in = zero;
+	for (size_t r = 0; r < count; ++ r) {
+		__m128i dist = _mm_subs_epu8(_mm_sub_epi8(x, first[r]), width[r]);
+		in = _mm_or_si128(in, _mm_cmpeq_epi8(dist, zero));
 	}
 
-	return SV_NPOS;
+	return in;
 }
+#endif
 
-size_t sv_find_last(sv_t sv, char ch) {
-	for (size_t i = sv.len - 1; i != SV_NPOS; -- i) {
-		if (sv_at(sv, i) == ch)
+/* Returns the index of the first char of 'str' that is in 'set', or if 'not_' is true, the first
+   one that is not */
+static size_t sv_scan_set_first(const char *str, size_t len, const sv_charset_t *set, bool not_) {
+	size_t i = 0;
+#ifdef SV_AVX2
+	const __m128i *bits   = (const __m128i*)set->bits;
+	__m256i        lo32   = _mm256_broadcastsi128_si256(_mm_loadu_si128(bits));
+	__m256i        hi32   = _mm256_broadcastsi128_si256(_mm_loadu_si128(bits + 1));
+	unsigned       flip32 = not_? 0xFFFFFFFF : 0;
+	for (; i + 32 <= len; i += 32) {
+		__m256i  block = _mm256_loadu_si256((const __m256i*)(str + i));
+		unsigned mask  = (unsigned)_mm256_movemask_epi8(sv_classify32(block, lo32, hi32)) ^ flip32;
+		if (mask != 0)
+			return i + sv_ctz(mask);
+	}
+#endif
+
+#ifdef SV_SSSE3
+	__m128i  lo16   = _mm_loadu_si128((const __m128i*)set->bits);
+	__m128i  hi16   = _mm_loadu_si128((const __m128i*)(set->bits + 16));
+	unsigned flip16 = not_? 0xFFFF : 0;
+	for (; i + 16 <= len; i += 16) {
+		__m128i  block = _mm_loadu_si128((const __m128i*)(str + i));
+		unsigned mask  = (unsigned)_mm_movemask_epi8(sv_classify16(block, lo16, hi16)) ^ flip16;
+		if (mask != 0)
+			return i + sv_ctz(mask);
+	}
+#endif
+
+#if defined(SV_SSE2) && !defined(SV_SSSE3)
+	__m128i first[SV_SET_RANGES], width[SV_SET_RANGES];
+	size_t  ranges = len >= SV_SET_MIN_LEN? sv_set_ranges(set, first, width) : SV_NPOS;
+	if (ranges != SV_NPOS) {
+		unsigned flip = not_? 0xFFFF : 0;
+		for (; i + 16 <= len; i += 16) {
+			__m128i  block = _mm_loadu_si128((const __m128i*)(str + i));
+			__m128i  in    = sv_classify16_ranges(block, first, width, ranges);
+			unsigned mask  = (unsigned)_mm_movemask_epi8(in) ^ flip;
+			if (mask != 0)
+				return i + sv_ctz(mask);
+		}
+	}
+#endif
+
+	for (; i < len; ++ i) {
+		if (sv_charset_has(set, str[i]) != not_)
 			return i;
 	}
 
 	return SV_NPOS;
 }
 
-size_t sv_find_first_not(sv_t sv, char ch) {
-	for (size_t i = 0; i < sv.len; ++ i) {
-		if (sv_at(sv, i) != ch)
+/* Same as sv_scan_set_first, but returns the last matching char */
+static size_t sv_scan_set_last(const char *str, size_t len, const sv_charset_t *set, bool not_) {
+	size_t i = len;
+#ifdef SV_AVX2
+	const __m128i *bits   = (const __m128i*)set->bits;
+	__m256i        lo32   = _mm256_broadcastsi128_si256(_mm_loadu_si128(bits));
+	__m256i        hi32   = _mm256_broadcastsi128_si256(_mm_loadu_si128(bits + 1));
+	unsigned       flip32 = not_? 0xFFFFFFFF : 0;
+	for (; i >= 32; i -= 32) {
+		__m256i  block = _mm256_loadu_si256((const __m256i*)(str + i - 32));
+		unsigned mask  = (unsigned)_mm256_movemask_epi8(sv_classify32(block, lo32, hi32)) ^ flip32;
+		if (mask != 0)
+			return i - 32 + sv_log2(mask);
+	}
+#endif
+
+#ifdef SV_SSSE3
+	__m128i  lo16   = _mm_loadu_si128((const __m128i*)set->bits);
+	__m128i  hi16   = _mm_loadu_si128((const __m128i*)(set->bits + 16));
+	unsigned flip16 = not_? 0xFFFF : 0;
+	for (; i >= 16; i -= 16) {
+		__m128i  block = _mm_loadu_si128((const __m128i*)(str + i - 16));
+		unsigned mask  = (unsigned)_mm_movemask_epi8(sv_classify16(block, lo16, hi16)) ^ flip16;
+		if (mask != 0)
+			return i - 16 + sv_log2(mask);
+	}
+#endif
+
+#if defined(SV_SSE2) && !defined(SV_SSSE3)
+	__m128i first[SV_SET_RANGES], width[SV_SET_RANGES];
+	size_t  ranges = len >= SV_SET_MIN_LEN? sv_set_ranges(set, first, width) : SV_NPOS;
+	if (ranges != SV_NPOS) {
+		unsigned flip = not_? 0xFFFF : 0;
+		for (; i >= 16; i -= 16) {
+			__m128i  block = _mm_loadu_si128((const __m128i*)(str + i - 16));
+			__m128i  in    = sv_classify16_ranges(block, first, width, ranges);
+			unsigned mask  = (unsigned)_mm_movemask_epi8(in) ^ flip;
+			if (mask != 0)
+				return i - 16 + sv_log2(mask);
+		}
+	}
+#endif
+
+	while (i -- > 0) {
+		if (sv_charset_has(set, str[i]) != not_)
 			return i;
 	}
 
 	return SV_NPOS;
 }
 
+sv_t sv_trim_front_set(sv_t sv, const sv_charset_t *set) {
+	size_t start = sv_span(sv, set);
+	sv.cstr += start;
+	sv.len  -= start;
+	return sv;
+}
+
+sv_t sv_trim_back_set(sv_t sv, const sv_charset_t *set) {
+	sv.len = sv_find_last_not_of(sv, set) + 1; /* SV_NPOS + 1 wraps around to 0 */
+	return sv;
+}
+
+sv_t sv_trim_set(sv_t sv, const sv_charset_t *set) {
+	sv =   sv_trim_front_set(sv, set);
+	return sv_trim_back_set( sv, set);
+}
+
+size_t sv_find_first_of(sv_t sv, const sv_charset_t *set) {
+	return sv_scan_set_first(sv.cstr, sv.len, set, false);
+}
+
+size_t sv_find_first_not_of(sv_t sv, const sv_charset_t *set) {
+	return sv_scan_set_first(sv.cstr, sv.len, set, true);
+}
+
+size_t sv_find_last_of(sv_t sv, const sv_charset_t *set) {
+	return sv_scan_set_last(sv.cstr, sv.len, set, false);
+}
+
+size_t sv_find_last_not_of(sv_t sv, const sv_charset_t *set) {
+	return sv_scan_set_last(sv.cstr, sv.len, set, true);
+}
+
+size_t sv_span(sv_t sv, const sv_charset_t *set) {
+	size_t idx = sv_find_first_not_of(sv, set);
+	return idx == SV_NPOS? sv.len : idx;
+}
+
+size_t sv_cspan(sv_t sv, const sv_charset_t *set) {
+	size_t idx = sv_find_first_of(sv, set);
+	return idx == SV_NPOS? sv.len : idx;
+}
+
+bool sv_contains(sv_t sv, char ch) {
+	return sv_find_first(sv, ch) != SV_NPOS;
+}
+
+size_t sv_find_first(sv_t sv, char ch) {
+	if (sv.len == 0)
+		return SV_NPOS;
+
+	const char *found = (const char*)memchr(sv.cstr, ch, sv.len);
+	return found == NULL? SV_NPOS : (size_t)(found - sv.cstr);
+}
+
+size_t sv_find_last(sv_t sv, char ch) {
+	return sv_scan_last(sv.cstr, sv.len, ch, false);
+}
+
+size_t sv_find_first_not(sv_t sv, char ch) {
+	return sv_scan_first(sv.cstr, sv.len, ch, true);
+}
+
 size_t sv_find_last_not(sv_t sv, char ch) {
-	for (size_t i = sv.len - 1; i != SV_NPOS; -- i) {
-		if (sv_at(sv, i) != ch)
+	return sv_scan_last(sv.cstr, sv.len, ch, true);
+}
+
+bool sv_contains_substr(sv_t sv, sv_t substr) {
+	return sv_find_substr(sv, substr) != SV_NPOS;
+}
+
+/* Finds the needle 'n' of length 'm' (at least 2) in 'h' of length 'len' (at least 'm'). A
+   position can only match if both the first and the last char of the needle match, which the
+   SIMD loops test for a whole block of positions at once */
+static size_t sv_find_short(const char *h, size_t len, const char *n, size_t m) {
+	size_t i = 0, count = len - m + 1;
+#ifdef SV_AVX2
+	__m256i first32 = _mm256_set1_epi8(n[0]), last32 = _mm256_set1_epi8(n[m - 1]);
+	for (; i + 32 <= count; i += 32) {
+		__m256i  a    = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(h + i)), first32);
+		__m256i  b    = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(h + i + m - 1)),
+		                                  last32);
+		unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_and_si256(a, b));
+		for (; mask != 0; mask &= mask - 1) {
+			size_t pos = i + sv_ctz(mask);
+			if (memcmp(h + pos + 1, n + 1, m - 2) == 0)
+				return pos;
+		}
+	}
+#endif
+
+#ifdef SV_SSE2
+	__m128i first16 = _mm_set1_epi8(n[0]), last16 = _mm_set1_epi8(n[m - 1]);
+	for (; i + 16 <= count; i += 16) {
+		__m128i  a    = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(h + i)), first16);
+		__m128i  b    = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(h + i + m - 1)), last16);
+		unsigned mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(a, b));
+		for (; mask != 0; mask &= mask - 1) {
+			size_t pos = i + sv_ctz(mask);
+			if (memcmp(h + pos + 1, n + 1, m - 2) == 0)
+				return pos;
+		}
+	}
+#endif
+
+	while (i < count) {
+		const char *found = (const char*)memchr(h + i, n[0], count - i);
+		if (found == NULL)
+			break;
+
+		i = (size_t)(found - h);
+		if (h[i + m - 1] == n[m - 1] && memcmp(h + i + 1, n + 1, m - 2) == 0)
 			return i;
+
+		++ i;
 	}
 
 	return SV_NPOS;
 }
 
-bool sv_contains_substr(sv_t sv, sv_t substr) {
-	if (substr.len > sv.len)
-		return false;
-
-	for (size_t i = 0; i < sv.len - (substr.len - 1); ++ i) {
-		bool matched = true;
-		for (size_t j = 0; j < substr.len; ++ j) {
-			if (sv_at(sv, i + j) != sv_at(substr, j)) {
-				matched = false;
-				break;
-			}
+/* Computes the maximal suffix of 'n' for the ordering 'inv' (false for <, true for >). Returns
+   its start minus one (wrapping around for -1) and writes its period to 'period' */
+static size_t sv_max_suffix(const unsigned char *n, size_t m, bool inv, size_t *period) {
+	size_t ip = SV_NPOS, jp = 0, k = 1, p = 1;
+	while (jp + k < m) {
+		unsigned char a = n[ip + k], b = n[jp + k];
+		if (a == b) {
+			if (k == p) {
+				jp += p;
+				k   = 1;
+			} else
+				++ k;
+		} else if ((a > b) != inv) {
+			jp += k;
+			k   = 1;
+			p   = jp - ip;
+		} else {
+			ip = jp ++;
+			k  = 1;
+			p  = 1;
 		}
-
-		if (matched)
-			return true;
 	}
 
-	return false;
+	*period = p;
+	return ip;
 }
 
+void sv_searcher_init(sv_searcher_t *s, sv_t needle) {
+	s->needle = needle;
+	if (needle.len <= SV_SHORT_NEEDLE)
+		return;
+
+	const unsigned char *n = (const unsigned char*)needle.cstr;
+	size_t               m = needle.len;
+
+	memset(s->shift, 0, sizeof(s->shift));
+	for (size_t i = 0; i < m; ++ i)
+		s->shift[n[i]] = i + 1;
+
+	/* The critical factorization is the later of the two maximal suffixes */
+	size_t p1, p2;
+	size_t ms1 = sv_max_suffix(n, m, false, &p1);
+	size_t ms2 = sv_max_suffix(n, m, true,  &p2);
+	if (ms2 + 1 > ms1 + 1) {
+		s->ms     = ms2;
+		s->period = p2;
+	} else {
+		s->ms     = ms1;
+		s->period = p1;
+	}
 
-size_t sv_find_substr(sv_t sv, sv_t substr) {
-	if (substr.len > sv.len)
+	s->periodic = memcmp(n, n + s->period, s->ms + 1) == 0;
+	if (!s->periodic)
+		s->period = (s->ms > m - s->ms - 1? s->ms : m - s->ms - 1) + 1;
+}
+
+size_t sv_searcher_find(const sv_searcher_t *s, sv_t sv) {
+	size_t m = s->needle.len;
+	if (m > sv.len)
 		return SV_NPOS;
+	else if (m == 0)
+		return 0;
+	else if (m == 1)
+		return sv_find_first(sv, s->needle.cstr[0]);
+	else if (m <= SV_SHORT_NEEDLE)
+		return sv_find_short(sv.cstr, sv.len, s->needle.cstr, m);
+
+	const unsigned char *h = (const unsigned char*)sv.cstr;
+	const unsigned char *n = (const unsigned char*)s->needle.cstr;
+
+	/* 'mem' is the length of the prefix already known to match after a shift by the period of a
+	   periodic needle, so it is not compared again */
+	size_t ms = s->ms, mem0 = s->periodic? m - s->period : 0, mem = 0;
+	for (size_t i = 0; sv.len - i >= m;) {
+		/* Align the last occurrence of the last char of the window in the needle */
+		size_t k = m - s->shift[h[i + m - 1]];
+		if (k != 0) {
+			i  += k < mem? mem : k;
+			mem = 0;
+			continue;
+		}
+
+		/* Compare the right half */
+		for (k = ms + 1 > mem? ms + 1 : mem; k < m && n[k] == h[i + k]; ++ k)
+			;
 
-	for (size_t i = 0; i < sv.len - (substr.len - 1); ++ i) {
-		bool matched = true;
-		for (size_t j = 0; j < substr.len; ++ j) {
-			if (sv_at(sv, i + j) != sv_at(substr, j)) {
-				matched = false;
-				break;
-			}
+		if (k < m) {
+			i  += k - ms;
+			mem = 0;
+			continue;
 		}
 
-		if (matched)
+		/* Compare the left half */
+		for (k = ms + 1; k > mem && n[k - 1] == h[i + k - 1]; -- k)
+			;
+
+		if (k <= mem)
 			return i;
+
+		i  += s->period;
+		mem = mem0;
 	}
 
 	return SV_NPOS;
 }
 
+size_t sv_find_substr(sv_t sv, sv_t substr) {
+	if (substr.len > sv.len)
+		return SV_NPOS;
+	else if (substr.len == 0)
+		return 0;
+	else if (substr.len == 1)
+		return sv_find_first(sv, substr.cstr[0]);
+	else if (substr.len <= SV_SHORT_NEEDLE)
+		return sv_find_short(sv.cstr, sv.len, substr.cstr, substr.len);
+
+	sv_searcher_t s;
+	sv_searcher_init(&s, substr);
+	return sv_searcher_find(&s, sv);
+}
+
 #ifdef __cplusplus
 }
 #endif
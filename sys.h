@@ -41,6 +41,19 @@ extern "C" {
 
 #	include <windows.h>
 #else
+/* glibc and musl hide the POSIX functions (like kill) in the strict C modes (-std=c99) unless a
+   feature test macro is defined. The macro only has an effect if this header is included before
+   any system header, the __USE_ macros below cover the other case on glibc. */
+#	if defined(__linux__) && !defined(_POSIX_C_SOURCE) && !defined(_XOPEN_SOURCE) && \
+	   !defined(_GNU_SOURCE) && !defined(_DEFAULT_SOURCE)
+#		define _POSIX_C_SOURCE 200809L
+#		define _DEFAULT_SOURCE
+#	endif
+
+#	ifndef __USE_POSIX
+#		define __USE_POSIX
+#	endif
+
 #	ifndef __USE_XOPEN_EXTENDED
 #		define __USE_XOPEN_EXTENDED
 #	endif